@@ -28,7 +28,8 @@ public:
     FunctionModel(std::string ReturnType_, std::string Name, std::string Description,
                   bool Volatile_=false, bool Time_=false, bool Threadsafe_=false,
                   std::string helpID_="",
-                  bool asynchronous=false,bool macrosheet=false, bool clustersafe=false);
+                  bool asynchronous=false,bool macrosheet=false, bool clustersafe=false,
+                  std::string inPlaceArgument="");
 
     void AddArgument(std::string Type_, std::string Name_, std::string Description_);
 
@@ -102,6 +103,11 @@ public:
         return ClusterSafe;
     }
 
+    std::string GetInPlaceArgument() const
+    {
+        return InPlaceArgument;
+    }
+
 private:
     std::string ReturnType;
     std::string FunctionName;
@@ -113,6 +119,7 @@ private:
     bool Asynchronous;
     bool MacroSheet;
     bool ClusterSafe;
+    std::string InPlaceArgument;
 
     std::vector<std::string > ArgumentTypes;
     std::vector<std::string > ArgumentNames;
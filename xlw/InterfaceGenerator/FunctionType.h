@@ -98,8 +98,28 @@ std::vector<FunctionDescription> FunctionTyper(std::vector<FunctionModel>& input
             Arguments.push_back(thisArgument);
         }
 
+        // Excel is told which argument holds the result by a single digit
+        // in place of the return type, and only FP arrays can be used this way
+        unsigned long inPlaceArgument = 0;
+        if (!it->GetInPlaceArgument().empty())
+        {
+            if (returnType != "void")
+                throw("function with <xlw:inplace must return void "+name);
+            for (unsigned long i=0; i < Arguments.size(); i++)
+            {
+                if (Arguments[i].GetArgumentName() == it->GetInPlaceArgument())
+                    inPlaceArgument = i+1;
+            }
+            if (inPlaceArgument == 0)
+                throw("<xlw:inplace names an unknown argument "+it->GetInPlaceArgument()+" in "+name);
+            if (inPlaceArgument > 9)
+                throw("<xlw:inplace argument must be one of the first nine in "+name);
+            if (Arguments[inPlaceArgument-1].GetTheType().GetEXCELKey() != "XLW_FP")
+                throw("<xlw:inplace argument must be an FP array such as MatrixSpan in "+name);
+        }
+
         FunctionDescription thisDescription(name,desc,returnType,key,Arguments,it->GetVolatile(),it->DoTime(),it->GetThreadsafe(),it->GetHelpID(),
-                                            it->GetAsynchronous(), it->GetMacroSheet(), it->GetClusterSafe());
+                                            it->GetAsynchronous(), it->GetMacroSheet(), it->GetClusterSafe(), inPlaceArgument);
         output.push_back(thisDescription);
         ++it;
     }
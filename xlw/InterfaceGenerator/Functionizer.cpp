@@ -80,6 +80,7 @@ FunctionModel FunctionFind(std::vector<Token>::const_iterator& it, std::vector<T
     bool macrosheet = false;
     bool clustersafe = false;
     std::string helpID = "";
+    std::string inPlaceArgument = "";
 
     if (it == end)
         throw("function half declared at end of file");
@@ -155,6 +156,14 @@ FunctionModel FunctionFind(std::vector<Token>::const_iterator& it, std::vector<T
             if (it == end)
                 throw("function half declared at end of file");
         }
+        if (commentString.find("<xlw:inplace=") == 0 )
+        {
+            inPlaceArgument = commentString.substr(13);
+            ++it;
+            found = true;
+            if (it == end)
+                throw("function half declared at end of file");
+        }
         if (!found)
             throw("unknown xlw command: "+commentString);
     }
@@ -165,7 +174,7 @@ FunctionModel FunctionFind(std::vector<Token>::const_iterator& it, std::vector<T
     std::string functionName(it->GetValue());
 
     FunctionModel theFunction(returnType,functionName,functionDesc,Volatile,time,threadsafe,
-        helpID,asynchronous,macrosheet,clustersafe);
+        helpID,asynchronous,macrosheet,clustersafe,inPlaceArgument);
 
     ++it;
     if (it == end)
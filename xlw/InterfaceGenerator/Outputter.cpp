@@ -88,7 +88,10 @@ std::vector<char> OutputFileCreator(const std::vector<FunctionDescription>& func
 
   for (unsigned long i=0; i < functionDescriptions.size(); i++)
   {
-    bool isCommand(functionDescriptions[i].GetReturnType() == "void");
+    // an in place function returns void too but its result is
+    // written into one of its arguments
+    unsigned long inPlaceArgument(functionDescriptions[i].GetInPlaceArgument());
+    bool isCommand(functionDescriptions[i].GetReturnType() == "void" && inPlaceArgument == 0);
     std::string name = functionDescriptions[i].GetFunctionName();
     std::string display_name = functionDescriptions[i].GetDisplayName();
     //std::string keys;
@@ -184,7 +187,14 @@ std::vector<char> OutputFileCreator(const std::vector<FunctionDescription>& func
           AddLine(output,",true");
         else
           AddLine(output,",false");
-        AddLine(output,",\"\"");
+        if (inPlaceArgument > 0)
+        {
+            std::ostringstream returnCode;
+            returnCode << ",\"" << inPlaceArgument << "\"";
+            AddLine(output,returnCode.str());
+        }
+        else
+          AddLine(output,",\"\"");
         if ( functionDescriptions[i].GetHelpID().length() > 0 )
         {
             std::string helpline(",");
@@ -220,7 +230,10 @@ std::vector<char> OutputFileCreator(const std::vector<FunctionDescription>& func
         AddLine(output,"{");
 
         //AddLine(output,"LPXLOPER EXCEL_EXPORT");
-        AddLine(output,"LPXLFOPER EXCEL_EXPORT");
+        if (inPlaceArgument > 0)
+          AddLine(output,"void EXCEL_EXPORT");
+        else
+          AddLine(output,"LPXLFOPER EXCEL_EXPORT");
         AddLine(output,"xl"+name+"(");
 
 
@@ -251,10 +264,13 @@ std::vector<char> OutputFileCreator(const std::vector<FunctionDescription>& func
         AddLine(output,"{");
         AddLine(output,"EXCEL_BEGIN;");
         AddLine(output,"");
-        if(functionDescriptions[i].GetReturnType() != "void")
+        if(functionDescriptions[i].GetReturnType() != "void" || inPlaceArgument > 0)
         {
             AddLine( output, "\tif (XlfExcel::Instance().IsCalledByFuncWiz())");
-            AddLine(output,"\t\treturn XlfOper(true);");
+            if (inPlaceArgument > 0)
+              AddLine(output,"\t\treturn;");
+            else
+              AddLine(output,"\t\treturn XlfOper(true);");
             AddLine(output,"");
 
             {for (unsigned long j=0; j < functionDescriptions[i].NumberOfArguments(); j++)
@@ -302,12 +318,15 @@ std::vector<char> OutputFileCreator(const std::vector<FunctionDescription>& func
 
             }}
 
-            if (functionDescriptions[i].DoTime())
+            // there's no result to append the time taken to
+            bool doTime(functionDescriptions[i].DoTime() && inPlaceArgument == 0);
+            if (doTime)
             {
               AddLine(output," HiResTimer t;");
             }
 
-            AddLine(output,functionDescriptions[i].GetReturnType()+" result(");
+            if (inPlaceArgument == 0)
+              AddLine(output,functionDescriptions[i].GetReturnType()+" result(");
             if (functionDescriptions[i].NumberOfArguments() >0)
             {
               AddLine(output,'\t'+functionDescriptions[i].GetFunctionName()+"(");
@@ -321,14 +340,21 @@ std::vector<char> OutputFileCreator(const std::vector<FunctionDescription>& func
 
                 AddLine(output,"\t\t"+functionDescriptions[i].GetArgument(j).GetArgumentName()+delimiter);
               }
-              AddLine(output,"\t);");
+              if (inPlaceArgument > 0)
+                AddLine(output,"\t;");
+              else
+                AddLine(output,"\t);");
             }
             else
               AddLine(output,'\t'+functionDescriptions[i].GetFunctionName()+"());");
 
-            if (functionDescriptions[i].DoTime())
+            if (inPlaceArgument > 0)
             {
-              AddLine(output,"CellMatrix resultCells(result);");
+              // nothing to return, Excel reads the argument back
+            }
+            else if (doTime)
+            {
+              AddLine(output,"CellMatrix resultCells(std::move(result));");
               AddLine(output,"CellMatrix time(1,2);");
               AddLine(output,"time(0,0) = \"time taken\";");
               AddLine(output,"time(0,1) = t.elapsed();");
@@ -344,7 +370,15 @@ std::vector<char> OutputFileCreator(const std::vector<FunctionDescription>& func
         {
             AddLine(output,'\t'+functionDescriptions[i].GetFunctionName()+"();");
         }
-        AddLine(    output,"EXCEL_END");
+        if (inPlaceArgument > 0)
+        {
+          // the raw FP12 argument, named as in the export's argument list
+          const FunctionArgument& inPlace(functionDescriptions[i].GetArgument(inPlaceArgument - 1));
+          std::string uniqifier(inPlace.GetTheType().GetConversionChain().size() == 1 ? "" : "a");
+          AddLine(    output,"EXCEL_END_INPLACE("+inPlace.GetArgumentName()+uniqifier+")");
+        }
+        else
+          AddLine(    output,"EXCEL_END");
 
         AddLine(output,"}");
 
@@ -115,7 +115,8 @@ FunctionDescription::FunctionDescription(std::string FunctionName_,
                          std::string helpID_,
                          bool Asynchronous_,
                          bool MacroSheet_,
-                         bool ClusterSafe_)
+                         bool ClusterSafe_,
+                         unsigned long InPlaceArgument_)
                          :
                          FunctionName(FunctionName_),
                          DisplayName(FunctionName_),
@@ -129,7 +130,8 @@ FunctionDescription::FunctionDescription(std::string FunctionName_,
                          Threadsafe(Threadsafe_),
                          Asynchronous(Asynchronous_),
                          MacroSheet(MacroSheet_),
-                         ClusterSafe(ClusterSafe_)
+                         ClusterSafe(ClusterSafe_),
+                         InPlaceArgument(InPlaceArgument_)
 {
 }
 
@@ -177,6 +179,11 @@ bool FunctionDescription::GetClusterSafe() const
     return ClusterSafe;
 }
 
+unsigned long FunctionDescription::GetInPlaceArgument() const
+{
+    return InPlaceArgument;
+}
+
 #include<iostream>
 void FunctionDescription::Transit(const std::vector<FunctionDescription> &source, 
 			 std::vector<FunctionDescription> & destination)
@@ -196,6 +203,7 @@ void FunctionDescription::Transit(const std::vector<FunctionDescription> &source
 		destination[i].Threadsafe               = source[i].Threadsafe  ;
 		destination[i].Time                     = source[i].Time  ;
 		destination[i].Volatile                 = source[i].Volatile  ;
+		destination[i].InPlaceArgument          = source[i].InPlaceArgument  ;
 
 		if(destination[i].FunctionName != source[i].FunctionName)
 		{
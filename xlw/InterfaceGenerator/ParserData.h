@@ -70,7 +70,8 @@ public:
                          std::string helpID_,
                          bool Asynchronous_,
                          bool MacroSheet_,
-                         bool ClusterSafe_);
+                         bool ClusterSafe_,
+                         unsigned long InPlaceArgument_ = 0);
 
      std::string GetFunctionName() const;
      std::string GetDisplayName() const;
@@ -86,6 +87,8 @@ public:
      bool GetAsynchronous() const;
      bool GetMacroSheet() const;
      bool GetClusterSafe() const;
+     //! One based index of the argument the result is written into, zero if there isn't one
+     unsigned long GetInPlaceArgument() const;
      void setFunctionName(const std::string &newName);
 
 	 static void Transit(const std::vector<FunctionDescription> &source, 
@@ -107,6 +110,7 @@ private:
      bool Asynchronous;
      bool MacroSheet;
      bool ClusterSafe;
+     unsigned long InPlaceArgument;
 };
 
 
@@ -58,6 +58,25 @@ TypeRegistry<native>::Helper arrayFundamentalReg("NEMatrix", // New type
                "<xlw/xlarray.h>"// Include file
                );
 
+// the spans use the doubles Excel passes in directly, no copy is made
+TypeRegistry<native>::Helper constSpanReg("ConstMatrixSpan", // New type
+               "LPXLARRAY",     // Old type
+               "",              // Converter name, we just pass into the constructor as a declaration
+               false,           // Is a method
+               false,           // Takes identifier
+               "XLW_FP",        // Type code
+               "<xlw/xlarray.h>"// Include file
+               );
+
+TypeRegistry<native>::Helper spanReg("MatrixSpan", // New type
+               "LPXLARRAY",     // Old type
+               "",              // Converter name, we just pass into the constructor as a declaration
+               false,           // Is a method
+               false,           // Takes identifier
+               "XLW_FP",        // Type code
+               "<xlw/xlarray.h>"// Include file
+               );
+
 TypeRegistry<native>::Helper shortreg("short", // New type
                "XlfOper",       // Old type
                "AsShort",       // Converter name
@@ -90,6 +109,16 @@ TypeRegistry<native>::Helper cellsreg("CellMatrix", // New type
                "XLF_OPER"       // Type code
                );
 
+// reads the array Excel passes in directly, no copy is made
+TypeRegistry<native>::Helper operviewreg("OperView", // New type
+               "LPXLFOPER",     // Old type
+               "",              // Converter name, we just pass into the constructor as a declaration
+               false,           // Is a method
+               false,           // Takes identifier
+               "XLF_OPER",      // Type code
+               "<xlw/OperView.h>"// Include file
+               );
+
 TypeRegistry<native>::Helper stringreg("string", // New type
                "XlfOper",       // Old type
                "AsString",      // Converter name
@@ -148,6 +177,32 @@ TypeRegistry<native>::Helper wstrreg("std::wstring", // New type
                true,            // Takes identifier
                "XLF_OPER");
 
+// converted straight between UTF-16 and UTF-8 rather than through the code page
+TypeRegistry<native>::Helper utf8reg("Utf8String", // New type
+               "XlfOper",       // Old type
+               "AsUtf8String",  // Converter name
+               true,            // Is a method
+               true,            // Takes identifier
+               "XLF_OPER"       // Type code
+               );
+
+// views of the string Excel passes in, valid until the function returns
+TypeRegistry<native>::Helper wstrviewreg("std::wstring_view", // New type
+               "XlfOper",       // Old type
+               "AsWstringView", // Converter name
+               true,            // Is a method
+               true,            // Takes identifier
+               "XLF_OPER"       // Type code
+               );
+
+TypeRegistry<native>::Helper strviewreg("std::string_view", // New type
+               "XlfOper",       // Old type
+               "AsStringView",  // Converter name
+               true,            // Is a method
+               true,            // Takes identifier
+               "XLF_OPER"       // Type code
+               );
+
 TypeRegistry<native>::Helper DONreg("DoubleOrNothing", // New type
                "CellMatrix",    // Old type
                "DoubleOrNothing", // Converter name
@@ -155,8 +210,9 @@ TypeRegistry<native>::Helper DONreg("DoubleOrNothing", // New type
                true             // Takes identifier
                );
 
+// parsed straight from the cells Excel passes in
 TypeRegistry<native>::Helper arglistreg("ArgumentList", // New type
-               "CellMatrix",    // Old type
+               "XlfOper",       // Old type
                "ArgumentList",  // Converter name
                false,           // Is a method
                true,            // Takes identifier
@@ -25,18 +25,123 @@
 
 #include "xlw/MyContainers.h"
 #include <xlw/CellMatrix.h>
-#include <map>
+#include <xlw/eshared_ptr.h>
+#include <xlw/xlcall32.h>
+#include <atomic>
 #include <string>
 #include <vector>
 
 namespace xlw {
 
+    class ArgumentSchema;
+    class XlfOper;
+
+    //! An argument name resolved by an ArgumentSchema
+    struct ArgumentSlot
+    {
+        const ArgumentSchema* Schema;
+        size_t Index;
+    };
+
+    //! Hash index of argument names that ignores the case of ASCII letters
+    /*!
+    Names are given positions 0, 1, 2... in the order they are inserted.
+    Lookups fold the case of the name as they hash it so need no copy.
+    Only A-Z are folded, which is all std::tolower does in the "C" locale
+    the names were lower cased with before.
+    */
+    class ArgumentNameIndex
+    {
+    public:
+        static const size_t npos = static_cast<size_t>(-1);
+
+        ArgumentNameIndex();
+
+        //! Gives name the next position, or returns npos if it is already there
+        size_t Insert(const std::string& name);
+        //! The position of name or npos
+        size_t Find(const std::string& name) const;
+
+        size_t Size() const
+        {
+            return Keys.size();
+        }
+        //! The lower case name at position
+        const std::string& Key(size_t position) const
+        {
+            return Keys[position];
+        }
+
+        static void FoldCase(std::string& name);
+
+    private:
+        size_t Find(const std::string& name, size_t hash) const;
+        void Rehash(size_t capacity);
+
+        std::vector<std::string> Keys;
+        std::vector<size_t> Hashes;
+        // position + 1 of the name hashed there, 0 when empty
+        std::vector<unsigned int> Table;
+    };
+
+    //! Argument names resolved once so reading an argument needs no string work
+    /*!
+    Typically a function builds one schema as a static, adding each name
+    it reads. The slot Add returns can then be passed to the ArgumentList
+    Get functions in place of the name: the first such call binds the
+    list's values to the schema, looking up each of its names once, and
+    from then on each lookup is an array index. The binding is shared by
+    every copy of the list, including those handed out by
+    ArgumentListCache, so is only made once per set of values.
+
+    Names may be added in any case and adding the same name twice gives
+    the same slot. A schema must not be changed while other threads are
+    reading arguments with it.
+    */
+    class ArgumentSchema
+    {
+    public:
+        ArgumentSlot Add(const std::string& ArgumentName);
+        //! The slot of a name already added
+        ArgumentSlot Slot(const std::string& ArgumentName) const;
+
+        size_t Size() const
+        {
+            return Names.Size();
+        }
+        //! The lower case name of the slot with index
+        const std::string& Name(size_t index) const
+        {
+            return Names.Key(index);
+        }
+        //! The index of the slot for name or ArgumentNameIndex::npos
+        size_t Find(const std::string& ArgumentName) const
+        {
+            return Names.Find(ArgumentName);
+        }
+
+    private:
+        ArgumentNameIndex Names;
+    };
+
     class ArgumentList
     {
     public:
 
         ArgumentList(CellMatrix cells, std::string ErrorIdentifier);
 
+        //! Reads the argument list straight from the cells Excel passed in
+        /*!
+        An array is read in place and a reference is coerced to one with
+        a single call to Excel, so unlike going through a CellMatrix the
+        block isn't copied. Only the values of vectors, matrices, cells and
+        lists are copied, as they are kept.
+
+        When ArgumentListCache has a capacity set, cells already parsed
+        give a list sharing the values parsed before.
+        */
+        ArgumentList(const XlfOper& cells, std::string ErrorIdentifier);
+
         ArgumentList(std::string name);
 
 
@@ -79,6 +184,28 @@ namespace xlw {
 
         bool IsArgumentPresent(const std::string& ArgumentName) const;
 
+        //! \name Lookups by schema slot
+        //@{
+        std::string GetStringArgumentValue(ArgumentSlot Argument);
+        unsigned long GetULArgumentValue(ArgumentSlot Argument);
+        double GetDoubleArgumentValue(ArgumentSlot Argument);
+        inline MyArray GetArrayArgumentValue(ArgumentSlot Argument);
+        inline MyMatrix GetMatrixArgumentValue(ArgumentSlot Argument);
+        bool GetBoolArgumentValue(ArgumentSlot Argument);
+        CellMatrix GetCellsArgumentValue(ArgumentSlot Argument);
+        ArgumentList GetArgumentListArgumentValue(ArgumentSlot Argument);
+
+        bool GetIfPresent(ArgumentSlot Argument, unsigned long& ArgumentValue);
+        bool GetIfPresent(ArgumentSlot Argument, double& ArgumentValue);
+        inline bool GetIfPresent(ArgumentSlot Argument, MyArray& ArgumentValue);
+        inline bool GetIfPresent(ArgumentSlot Argument, MyMatrix& ArgumentValue);
+        bool GetIfPresent(ArgumentSlot Argument, bool& ArgumentValue);
+        bool GetIfPresent(ArgumentSlot Argument, CellMatrix& ArgumentValue);
+        bool GetIfPresent(ArgumentSlot Argument, ArgumentList& ArgumentValue);
+
+        bool IsArgumentPresent(ArgumentSlot Argument) const;
+        //@}
+
         void CheckAllUsed(const std::string& ErrorId) const;
 
         CellMatrix AllData() const; // makes data into a cell matrix that could be used for
@@ -98,68 +225,97 @@ namespace xlw {
         void add(const std::string& ArgumentName, const ArgumentList& values);
 
     private:
+        // the position of each slot of Schema in a Values, or npos
+        struct Binding
+        {
+            const ArgumentSchema* Schema;
+            std::vector<size_t> Positions;
+            Binding* Next;
+        };
+
+        // the names and values, shared by copies of the list until one is added to
+        struct Values
+        {
+            Values();
+            // a copy starts with no bindings
+            Values(const Values& theOther);
+            ~Values();
+
+            std::string StructureName;
+            // names and types in the order added, indexed by Names
+            std::vector<std::pair<std::string, ArgumentType> > ArgumentNames;
+            ArgumentNameIndex Names;
+            // where each argument is held in the vector for its type
+            std::vector<size_t> ValuePositions;
+
+            std::vector<double> DoubleArguments;
+            std::vector<std::string> StringArguments;
+            std::vector<bool> BoolArguments;
+            // vectors, matrices, cells and lists
+            std::vector<CellMatrix> CellArguments;
+
+            // the schemas bound so far, most recent first; only pushed on to
+            // while shared, so readers on other threads never see one freed
+            mutable std::atomic<Binding*> Bindings;
+            void ClearBindings();
+
+        private:
+            Values& operator=(const Values&);
+        };
+
         template<class TYPE>
-        void addInternal(const std::string& ArgumentName, const TYPE& value, std::map<std::string, TYPE>& typeMap, ArgumentType type);
+        void addInternal(const std::string& ArgumentName, const TYPE& value, std::vector<TYPE> Values::* values, ArgumentType type);
         template<class TYPE>
-        const TYPE& GetArgumentValueInternal(std::string ArgumentName, std::map<std::string, TYPE>& typeMap);
-
+        void addInternal(const std::string& ArgumentName, TYPE&& value, std::vector<TYPE> Values::* values, ArgumentType type);
+        template<class BLOCK>
+        void Parse(const BLOCK& cells, std::string ErrorId);
+        void ParseElements(const XLOPER12* cells, size_t rows, size_t columns, const std::string& ErrorId);
+        template<class KEY>
+        size_t UseArgument(const KEY& key, ArgumentType type);
+
+        size_t Find(const std::string& ArgumentName) const;
+        size_t Find(ArgumentSlot Argument) const;
+        const Binding& Bind(const ArgumentSchema& schema) const;
+        static std::string NameOf(const std::string& ArgumentName);
+        static std::string NameOf(ArgumentSlot Argument);
 
         void addArray(const std::string& ArgumentName, const CellMatrix& values);
         void addMatrix(const std::string& ArgumentName, const CellMatrix& values);
         const CellMatrix& GetArrayArgumentValueInternal(const std::string& ArgumentName);
         const CellMatrix& GetMatrixArgumentValueInternal(const std::string& ArgumentName);
+        const CellMatrix& GetArrayArgumentValueInternal(ArgumentSlot Argument);
+        const CellMatrix& GetMatrixArgumentValueInternal(ArgumentSlot Argument);
+        template<class KEY>
+        MyArray GetArrayArgumentValueFor(const KEY& key);
+        template<class KEY>
+        MyMatrix GetMatrixArgumentValueFor(const KEY& key);
 
-        std::string StructureName;
-        std::vector<std::pair<std::string, ArgumentType> > ArgumentNames;
-        std::map<std::string,double> DoubleArguments;
-        std::map<std::string,CellMatrix> ArrayArguments;
-        std::map<std::string,CellMatrix> MatrixArguments;
-        std::map<std::string,std::string> StringArguments;
-        std::map<std::string,CellMatrix> ListArguments;
-
-
-        std::map<std::string,CellMatrix> CellArguments;
-        std::map<std::string,bool> BoolArguments;
+        void Unshare();
 
-        std::map<std::string,ArgumentType> Names;
-
-        std::map<std::string,bool> ArgumentsUsed;
+        eshared_ptr<Values> Data;
+        // which arguments have been read, by position
+        std::vector<bool> Used;
 
         void GenerateThrow(std::string message, size_t row, size_t column);
-        void UseArgumentName(const std::string& ArgumentName); // private as no error checking performed
         void RegisterName(const std::string& ArgumentName, ArgumentType type);
     };
 }
 
 inline void xlw::ArgumentList::add(const std::string& ArgumentName, const MyArray& value)
 {
-    size_t size(ArrayTraits<MyArray>::size(value));
-    CellMatrix convertedValue(size, 1);
-    for(size_t i(0); i < size; ++i)
-    {
-        convertedValue(i, 0) = ArrayTraits<MyArray>::getAt(value, i);
-    }
-    addMatrix(ArgumentName, convertedValue);
+    // the constructor fills the cells without marking them unshareable
+    addMatrix(ArgumentName, CellMatrix(value));
 }
 
 inline void xlw::ArgumentList::add(const std::string& ArgumentName, const MyMatrix& value)
 {
-    size_t rows(MatrixTraits<MyMatrix>::rows(value));
-    size_t columns(MatrixTraits<MyMatrix>::columns(value));
-    CellMatrix convertedValue(rows, columns);
-    for(size_t row(0); row < rows; ++row)
-    {
-        for(size_t col(0); col < columns; ++col)
-        {
-            convertedValue(row, col) = MatrixTraits<MyMatrix>::getAt(value, row, col);
-        }
-    }
-    addMatrix(ArgumentName, convertedValue);
+    addMatrix(ArgumentName, CellMatrix(value));
 }
 
-inline xlw::MyArray xlw::ArgumentList::GetArrayArgumentValue(const std::string& ArgumentName)
+template<class KEY>
+xlw::MyArray xlw::ArgumentList::GetArrayArgumentValueFor(const KEY& key)
 {
-    const CellMatrix& value(GetArrayArgumentValueInternal(ArgumentName));
+    const CellMatrix& value(GetArrayArgumentValueInternal(key));
     size_t size(value.RowsInStructure());
     MyArray returnValue(ArrayTraits<MyArray>::create(size));
     for(size_t i(0); i < size; ++i)
@@ -169,9 +325,10 @@ inline xlw::MyArray xlw::ArgumentList::GetArrayArgumentValue(const std::string&
     return returnValue;
 }
 
-inline xlw::MyMatrix xlw::ArgumentList::GetMatrixArgumentValue(const std::string& ArgumentName)
+template<class KEY>
+xlw::MyMatrix xlw::ArgumentList::GetMatrixArgumentValueFor(const KEY& key)
 {
-    const CellMatrix& value(GetMatrixArgumentValueInternal(ArgumentName));
+    const CellMatrix& value(GetMatrixArgumentValueInternal(key));
     size_t rows(value.RowsInStructure());
     size_t columns(value.ColumnsInStructure());
     MyMatrix returnValue(MatrixTraits<MyMatrix>::create(rows, columns));
@@ -185,6 +342,26 @@ inline xlw::MyMatrix xlw::ArgumentList::GetMatrixArgumentValue(const std::string
     return returnValue;
 }
 
+inline xlw::MyArray xlw::ArgumentList::GetArrayArgumentValue(const std::string& ArgumentName)
+{
+    return GetArrayArgumentValueFor(ArgumentName);
+}
+
+inline xlw::MyMatrix xlw::ArgumentList::GetMatrixArgumentValue(const std::string& ArgumentName)
+{
+    return GetMatrixArgumentValueFor(ArgumentName);
+}
+
+inline xlw::MyArray xlw::ArgumentList::GetArrayArgumentValue(ArgumentSlot Argument)
+{
+    return GetArrayArgumentValueFor(Argument);
+}
+
+inline xlw::MyMatrix xlw::ArgumentList::GetMatrixArgumentValue(ArgumentSlot Argument)
+{
+    return GetMatrixArgumentValueFor(Argument);
+}
+
 inline bool xlw::ArgumentList::GetIfPresent(const std::string& ArgumentName, MyArray& ArgumentValue)
 {
     if (!IsArgumentPresent(ArgumentName))
@@ -202,4 +379,22 @@ inline bool xlw::ArgumentList::GetIfPresent(const std::string& ArgumentName, MyM
     ArgumentValue = GetMatrixArgumentValue(ArgumentName);
     return true;
 }
+
+inline bool xlw::ArgumentList::GetIfPresent(ArgumentSlot Argument, MyArray& ArgumentValue)
+{
+    if (!IsArgumentPresent(Argument))
+        return false;
+
+    ArgumentValue = GetArrayArgumentValue(Argument);
+    return true;
+}
+
+inline bool xlw::ArgumentList::GetIfPresent(ArgumentSlot Argument, MyMatrix& ArgumentValue)
+{
+    if (!IsArgumentPresent(Argument))
+        return false;
+
+    ArgumentValue = GetMatrixArgumentValue(Argument);
+    return true;
+}
 #endif
@@ -0,0 +1,92 @@
+/*
+ This file is part of XLW, a free-software/open-source C++ wrapper of the
+ Excel C API - https://xlw.github.io/
+
+ XLW is free software: you can redistribute it and/or modify it under the
+ terms of the XLW license.  You should have received a copy of the
+ license along with this program; if not, please email xlw-users@lists.sf.net
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#ifndef INC_ArgumentListCache_H
+#define INC_ArgumentListCache_H
+
+/*!
+\file ArgumentListCache.h
+\brief Declares class ArgumentListCache.
+*/
+
+// $Id$
+
+#include <xlw/xlcall32.h>
+#include <string>
+#include <cstddef>
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+namespace xlw {
+
+    class ArgumentList;
+
+    //! Process wide cache of argument lists keyed by the contents of the cells they were read from
+    /*!
+    A parameter block referenced by many formulas is otherwise parsed
+    again by every one of them. Once a capacity is set the ArgumentList
+    constructor taking an XlfOper looks the cells up here first. A hit
+    gives a list sharing the values parsed the first time, with its own
+    record of which arguments have been read. The least recently used
+    lists are dropped to stay within the capacity.
+
+    Cells are matched on their whole contents rather than just a hash, so
+    a block that has changed is always parsed again. The cache takes a
+    lock so may be used during multi threaded recalculation.
+
+    \code
+    // when the add-in is opened
+    ArgumentListCache::SetCapacity(256);
+    \endcode
+    */
+    class ArgumentListCache
+    {
+    public:
+        struct Statistics
+        {
+            Statistics() : hits(0), misses(0), evictions(0), size(0) {}
+            //! Number of lists found in the cache
+            size_t hits;
+            //! Number of lists that had to be parsed
+            size_t misses;
+            //! Number of lists dropped to stay within the capacity
+            size_t evictions;
+            //! Number of lists held now
+            size_t size;
+        };
+
+        //! Sets the number of lists kept, 0, the default, turns the cache off
+        static void SetCapacity(size_t lists);
+        static size_t Capacity();
+        //! Drops all the lists held, leaving the counters alone
+        static void Clear();
+        static Statistics GetStatistics();
+
+        //! \name Use by ArgumentList
+        //@{
+        //! Writes the contents of rows * columns cells, laid out by row, to key
+        static void MakeKey(const XLOPER12* cells, size_t rows, size_t columns, std::string& key);
+        //! Sets list to the one held for key, false if there isn't one
+        static bool Find(const std::string& key, ArgumentList& list);
+        //! Keeps list for key, which mustn't be changed after
+        static void Insert(const std::string& key, const ArgumentList& list);
+        //@}
+
+    private:
+        ArgumentListCache();
+    };
+}
+
+#endif
@@ -0,0 +1,101 @@
+/*
+ This file is part of XLW, a free-software/open-source C++ wrapper of the
+ Excel C API - https://xlw.github.io/
+
+ XLW is free software: you can redistribute it and/or modify it under the
+ terms of the XLW license.  You should have received a copy of the
+ license along with this program; if not, please email xlw-users@lists.sf.net
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#ifndef INC_ArrayPacker_H
+#define INC_ArrayPacker_H
+
+/*!
+\file ArrayPacker.h
+\brief Declares class ArrayPacker.
+*/
+
+// $Id$
+
+#include <xlw/xlcall32.h>
+#include <string>
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+namespace xlw {
+
+    //! Builds an array result whose elements and strings share one block of temporary memory
+    /*!
+    Used in two passes. The first adds up the room the strings will need
+    using StringSpace, Allocate then takes a single block holding the
+    elements followed by the strings, and the second pass sets the
+    elements, writing the strings one after another from Strings().
+    Compared with setting each string on its own this makes one
+    allocation rather than one per string and leaves the strings next to
+    each other for Excel to read.
+
+    Rows and columns are truncated to what Excel allows, as
+    XlfOperProperties::setArraySize does. The static members don't touch
+    TempMemory so may be used by other threads on parts of the block.
+    */
+    class ArrayPacker
+    {
+    public:
+        ArrayPacker(size_t rows, size_t columns);
+
+        size_t Rows() const
+        {
+            return rows_;
+        }
+        size_t Columns() const
+        {
+            return columns_;
+        }
+
+        //! \name First pass
+        //@{
+        //! Wide characters a string takes in the block, including its length and terminator
+        static size_t StringSpace(const std::string& value);
+        static size_t StringSpace(const std::wstring& value);
+        static size_t StringSpace(const wchar_t* pascalString);
+        //@}
+
+        //! Takes the block with room for stringSpace wide characters after the elements
+        void Allocate(size_t stringSpace);
+
+        //! \name Second pass
+        //@{
+        //! The rows * columns elements, laid out by row
+        XLOPER12* Elements() const
+        {
+            return elements_;
+        }
+        //! Start of the room for strings
+        wchar_t* Strings() const
+        {
+            return strings_;
+        }
+        //! Makes element a string written at next, moving next on by the string's StringSpace
+        static void SetString(XLOPER12& element, const std::string& value, wchar_t*& next);
+        static void SetString(XLOPER12& element, const std::wstring& value, wchar_t*& next);
+        static void SetString(XLOPER12& element, const wchar_t* pascalString, wchar_t*& next);
+        //@}
+
+        //! Makes oper the array, or missing when there are no elements
+        void Finish(LPXLOPER12 oper) const;
+
+    private:
+        size_t rows_;
+        size_t columns_;
+        XLOPER12* elements_;
+        wchar_t* strings_;
+    };
+}
+
+#endif
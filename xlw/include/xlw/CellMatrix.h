@@ -23,6 +23,8 @@ FOR A PARTICULAR PURPOSE.  See the license for more details.
 #include "xlw/MyContainers.h"
 #include <string>
 #include <vector>
+#include <utility>
+#include <type_traits>
 
 namespace xlw {
 
@@ -31,14 +33,31 @@ namespace xlw {
 	{
 	public:
 
-		//Copy Constructor
-		CellMatrix(const CellMatrix &theOther):pimpl(theOther.pimpl.copy()){}
+		//Copy Constructor, the cells are shared until one of the matrices is changed
+		//Once a reference to a cell has been handed out by the non const operator()
+		//the matrix can't know when it is written to, so it is copied straight away.
+		//Cells are only shared when the implementation says its const reads write nothing,
+		//as the two matrices may then be read from different threads
+		CellMatrix(const CellMatrix &theOther)
+			:pimpl(theOther.Shareable && theOther.pimpl->IsSafeToShare() ? theOther.pimpl : theOther.pimpl.copy()){}
+
+		//Move Constructor, takes over the cells of theOther without copying them
+		//theOther is left sharing an empty matrix, so moving never allocates
+		CellMatrix(CellMatrix &&theOther) noexcept:pimpl(EmptyPimpl())
+		{
+			swap(theOther);
+		}
 
 
 		CellMatrix(size_t rows, size_t columns):pimpl(new CellMatrixImpl(rows, columns)){}
 
 		CellMatrix():pimpl(new CellMatrixImpl()){}
 
+		//Takes ownership of impl, which must have come from new, to use an implementation
+		//other than CellMatrixImpl
+		template<class Impl>
+		explicit CellMatrix(Impl* impl, typename std::enable_if<std::is_base_of<CellMatrix_pimpl_abstract, Impl>::value>::type* = 0):pimpl(impl){}
+
 
 		CellMatrix(double data):pimpl(new CellMatrixImpl(1,1))
 		{
@@ -100,12 +119,27 @@ namespace xlw {
 			return *this;
 		}
 
+		CellMatrix & operator=(CellMatrix &&theOther) noexcept
+		{
+			swap(theOther);
+			return *this;
+		}
+
 		const CellValue& operator()(size_t i, size_t j) const
 		{
-			return pimpl->operator()(i,j);
+			// the pointer doesn't pass on constness, so make sure the const
+			// overload is called, some implementations change their layout in the other
+			const CellMatrix_pimpl_abstract& impl(*pimpl);
+			return impl(i,j);
 		}
+		//Use a const matrix to read cells, this takes a copy of shared cells
 		CellValue& operator()(size_t i, size_t j) 
 		{	
+			if (Shareable)
+			{
+				Unshare();
+				Shareable = false;
+			}
 			return pimpl->operator()(i,j);
 		}
 
@@ -118,21 +152,68 @@ namespace xlw {
 			return pimpl->ColumnsInStructure();
 		}
 
+		//Column j as a typed array when the implementation stores it as one,
+		//otherwise the column's Type is TypedColumn::none
+		TypedColumn Column(size_t j) const
+		{
+			return pimpl->Column(j);
+		}
+
+		//Call before reading the cells from several threads at once, makes
+		//anything the implementation would otherwise make as cells are read
+		void PrepareForConcurrentRead() const
+		{
+			pimpl->PrepareForConcurrentRead();
+		}
+
+		//Adds the cells of newRows to the bottom, storage grows in place
+		//so building a matrix a few rows at a time doesn't copy it every time
 		void PushBottom(const CellMatrix & newRows)
 		{
-			CellMatrix temp(*this);
-			temp.pimpl->PushBottom(*(newRows.pimpl));
-			temp.swap(*this);
+			Unshare();
+			pimpl->PushBottom(*(newRows.pimpl));
+		}
 
+		//Adds rows of empty cells to the bottom
+		void AppendRows(size_t rows)
+		{
+			Unshare();
+			pimpl->AppendRows(rows);
 		}
 
-		void swap(CellMatrix &theOther)
+		//Makes room for this many rows in total
+		void Reserve(size_t rows)
+		{
+			Unshare();
+			pimpl->Reserve(rows);
+		}
+
+		void swap(CellMatrix &theOther) noexcept
 		{
 			pimpl.swap(theOther.pimpl);
+			std::swap(Shareable, theOther.Shareable);
 		}
 
 	private:
+		//The empty matrix moved-from matrices share, Unshare copies it before it is changed
+		static const eshared_ptr<CellMatrix_pimpl_abstract>& EmptyPimpl()
+		{
+			static const eshared_ptr<CellMatrix_pimpl_abstract> empty(new CellMatrixImpl());
+			return empty;
+		}
+
+		//Takes a copy of the cells if another matrix is sharing them
+		void Unshare()
+		{
+			if (pimpl.use_count() > 1)
+			{
+				pimpl = pimpl.copy();
+			}
+		}
+
 		eshared_ptr<CellMatrix_pimpl_abstract> pimpl;
+		//false once a reference to a cell has been handed out, after which the cells are never shared
+		bool Shareable = true;
 
 	};
 
@@ -143,6 +224,14 @@ namespace xlw {
 		return temp;
 	}
 
+	//Top is added to in place rather than copied
+	inline CellMatrix MergeCellMatrices(CellMatrix&& Top, const CellMatrix& Bottom)
+	{
+		CellMatrix temp(std::move(Top));
+		temp.PushBottom(Bottom);
+		return temp;
+	}
+
 
 
 }
@@ -24,6 +24,40 @@ FOR A PARTICULAR PURPOSE.  See the license for more details.
 
 namespace xlw {
 
+	/// A column of a cell matrix held as an array of a single type
+	/**
+	Only available from implementations that store their cells by column,
+	otherwise Type is none and the cells have to be read one at a time.
+	*/
+	struct TypedColumn
+	{
+		enum ColumnType
+		{
+			none, number, boolean, string
+		};
+
+		TypedColumn() : Type(none), Rows(0), Numbers(0), Booleans(0), StringIds(0), Strings(0), Validity(0) {}
+
+		/// is row i a value of the column's type, rather than empty or something else such as a header
+		bool IsValid(size_t i) const
+		{
+			return ((Validity[i / 64] >> (i % 64)) & 1) != 0;
+		}
+
+		ColumnType Type;
+		size_t Rows;
+		/// one per row for number columns
+		const double* Numbers;
+		/// one per row for boolean columns
+		const unsigned char* Booleans;
+		/// one per row for string columns, indexing Strings
+		const unsigned int* StringIds;
+		/// the distinct strings of a string column
+		const std::wstring* Strings;
+		/// bit i % 64 of word i / 64 is set when row i is valid
+		const unsigned long long* Validity;
+	};
+
 	class CellMatrix_pimpl_abstract
 	{
 	public:
@@ -34,10 +68,44 @@ namespace xlw {
 		virtual size_t RowsInStructure() const=0;
 		virtual size_t ColumnsInStructure() const=0;
 		virtual void PushBottom(const CellMatrix_pimpl_abstract& newRows)=0;
+		/// adds rows of empty cells to the bottom
+		virtual void AppendRows(size_t rows)=0;
+		/// makes room for this many rows in total so that adding rows doesn't reallocate
+		virtual void Reserve(size_t rows)=0;
+		/// the column as a typed array if it is stored as one
+		virtual TypedColumn Column(size_t) const
+		{
+			return TypedColumn();
+		}
+		/// can copies share this implementation, true only if const reads change nothing
+		/**
+		Implementations that fill in caches from their const members must
+		return false while such a cache could still be filled.
+		*/
+		virtual bool IsSafeToShare() const
+		{
+			return false;
+		}
+		/// fills in anything const reads would otherwise make on demand
+		/**
+		Called before several threads read the cells at once, so that
+		implementations with lazily made caches can make them up front.
+		*/
+		virtual void PrepareForConcurrentRead() const
+		{
+		}
 		virtual  ~CellMatrix_pimpl_abstract()
 		{
 		}
 
+	protected:
+		// implementations can be copied and moved but not through the interface
+		CellMatrix_pimpl_abstract() {}
+		CellMatrix_pimpl_abstract(const CellMatrix_pimpl_abstract&) {}
+		CellMatrix_pimpl_abstract(CellMatrix_pimpl_abstract&&) {}
+		CellMatrix_pimpl_abstract& operator=(const CellMatrix_pimpl_abstract&) { return *this; }
+		CellMatrix_pimpl_abstract& operator=(CellMatrix_pimpl_abstract&&) { return *this; }
+
 	};
 
 }
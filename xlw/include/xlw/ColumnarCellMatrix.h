@@ -0,0 +1,122 @@
+//
+//
+//                                  ColumnarCellMatrix.h
+//
+//
+/*
+This file is part of XLW, a free-software/open-source C++ wrapper of the
+Excel C API - https://xlw.github.io/
+
+XLW is free software: you can redistribute it and/or modify it under the
+terms of the XLW license.  You should have received a copy of the
+license along with this program; if not, please email xlw-users@lists.sf.net
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#ifndef COLUMNAR_CELL_MATRIX_H
+#define COLUMNAR_CELL_MATRIX_H
+
+
+#include <xlw/CellMatrixPimpl.h>
+#include <xlw/FlatCellMatrix.h>
+#include <string>
+#include <vector>
+
+struct xloper12;
+
+namespace xlw {
+
+	namespace impl
+	{
+
+		/// Cell matrix storing each column as an array of a single type where it can
+		/**
+		Built from a range passed in from Excel, each column whose values below
+		the first row all have one type is kept as an array of that type, so a
+		table with a header row keeps its header cells aside and the rest of the
+		column typed. Columns holding more than one type are kept as cells.
+		Typed columns are read through CellMatrix::Column.
+
+		Reading a typed column a cell at a time makes the cells of that column
+		on first use, so a matrix shouldn't be read that way by two threads at
+		once. Getting a cell to change, or adding rows, turns columns into
+		cells for good.
+
+		Select it by changing the CellMatrixImpl typedef in MyContainers.h,
+		XlfOper::AsCellMatrix then types the columns as it reads them.
+		*/
+		class ColumnarCellMatrix : public CellMatrix_pimpl_abstract
+		{
+		public:
+			ColumnarCellMatrix();
+			ColumnarCellMatrix(size_t rows, size_t columns);
+			/// reads rows * columns values laid out by row as Excel does for arrays
+			ColumnarCellMatrix(const xloper12* elements, size_t rows, size_t columns);
+
+			const CellValue& operator()(size_t i, size_t j) const;
+			CellValue& operator()(size_t i, size_t j);
+
+			size_t RowsInStructure() const
+			{
+				return Rows;
+			}
+			size_t ColumnsInStructure() const
+			{
+				return Data.size();
+			}
+
+			void PushBottom(const CellMatrix_pimpl_abstract& newRows);
+			void AppendRows(size_t rows);
+			void Reserve(size_t rows);
+
+			TypedColumn Column(size_t j) const;
+			/// not while a typed column has yet to make its cells
+			bool IsSafeToShare() const;
+			/// makes the cells of every typed column
+			void PrepareForConcurrentRead() const;
+
+		private:
+			struct ColumnData
+			{
+				ColumnData() : Type(TypedColumn::none) {}
+				TypedColumn::ColumnType Type;
+				std::vector<double> Numbers;
+				std::vector<unsigned char> Booleans;
+				std::vector<unsigned int> StringIds;
+				std::vector<std::wstring> Strings;
+				std::vector<unsigned long long> Validity;
+				/// the first cell when it isn't of the column's type, usually a header
+				FlatCellValue First;
+				/// the cells of an untyped column, made on demand for a typed one
+				mutable std::vector<FlatCellValue> Cells;
+			};
+
+			/// the cells of column j, made from its typed array if need be
+			std::vector<FlatCellValue>& CellsOf(size_t j) const;
+			/// stops column j being typed so its cells can be changed
+			void Untype(size_t j);
+
+			void check(size_t i, size_t j) const
+			{
+#ifdef _DEBUG
+				if (i >= Rows || j >= Data.size())
+					throw XlfOutOfBounds();
+#else
+				(void)i;
+				(void)j;
+#endif
+			}
+
+			std::vector<ColumnData> Data;
+			size_t Rows;
+
+		};
+
+
+	}
+}
+
+#endif // COLUMNAR_CELL_MATRIX_H
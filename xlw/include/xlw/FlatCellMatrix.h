@@ -0,0 +1,278 @@
+//
+//
+//                                  FlatCellMatrix.h
+//
+//
+/*
+This file is part of XLW, a free-software/open-source C++ wrapper of the
+Excel C API - https://xlw.github.io/
+
+XLW is free software: you can redistribute it and/or modify it under the
+terms of the XLW license.  You should have received a copy of the
+license along with this program; if not, please email xlw-users@lists.sf.net
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#ifndef FLAT_CELL_MATRIX_H
+#define FLAT_CELL_MATRIX_H
+
+
+#include <xlw/CellValue.h>
+#include <xlw/CellMatrixPimpl.h>
+#include <xlw/XlfException.h>
+#include <xlw/StringPool.h>
+#include <string>
+#include <vector>
+#include <atomic>
+
+namespace xlw {
+
+	namespace impl
+	{
+
+		/// A cell holding its type and a single value inline
+		/**
+		Numbers, booleans and errors are held in the cell itself, only strings
+		need memory of their own. Apart from the vtable pointer CellValue needs
+		a cell is just the type and an 8 byte value.
+
+		When StringPool::InternsCellStrings() is set wide strings are interned
+		and the cell keeps only their symbol. Should the pool be full the cell
+		keeps its own copy of the string as it would otherwise.
+		*/
+		class FlatCellValue : public CellValue
+		{
+			enum ValueType
+			{
+				string, wstring, symbol, number, boolean, error, empty
+			};
+
+			/// a string in the form it was given, with the other form made on demand
+			/**
+			The other form is published with a compare and swap, so a const
+			cell can be read from several threads at once.
+			*/
+			struct Text
+			{
+				explicit Text(const std::string& value) : Narrow(value), IsWide(false), MadeNarrow(0), MadeWide(0) {}
+				explicit Text(const std::wstring& value) : Wide(value), IsWide(true), MadeNarrow(0), MadeWide(0) {}
+				Text(const Text& theOther) : Narrow(theOther.Narrow), Wide(theOther.Wide), IsWide(theOther.IsWide), MadeNarrow(0), MadeWide(0) {}
+				~Text()
+				{
+					delete MadeNarrow.load(std::memory_order_relaxed);
+					delete MadeWide.load(std::memory_order_relaxed);
+				}
+				std::string Narrow;
+				std::wstring Wide;
+				bool IsWide;
+				mutable std::atomic<std::string*> MadeNarrow;
+				mutable std::atomic<std::wstring*> MadeWide;
+			};
+
+			ValueType Type;
+			union
+			{
+				double Number;
+				unsigned long Code;
+				bool Flag;
+				Text* String;
+				StringPool::Symbol Interned;
+			} Value;
+
+			/// does the cell own a Text
+			bool HasText() const { return Type == string || Type == wstring; }
+
+		public:
+			/// is value an ascii string type
+			bool IsAString() const { return Type == string; }
+			/// is value either an ascii or unicode string
+			bool IsString() const { return Type == string || Type == wstring || Type == symbol; }
+			/// is value a unicode string
+			bool IsAWstring() const { return Type == wstring || Type == symbol; }
+			bool IsANumber() const { return Type == number; }
+			bool IsBoolean() const { return Type == boolean; }
+			bool IsError() const { return Type == error; }
+			bool IsEmpty() const { return Type == empty; }
+			/// is value a string held in the StringPool
+			bool IsInterned() const { return Type == symbol; }
+			/// the pool symbol of an interned string, cells with equal symbols hold equal strings
+			StringPool::Symbol SymbolValue() const;
+
+			FlatCellValue() : Type(empty)
+			{
+				Value.Number = 0.0;
+			}
+			FlatCellValue(const FlatCellValue &);
+			/// leaves theOther empty, noexcept so vectors of cells move rather than copy when they grow
+			FlatCellValue(FlatCellValue &&theOther) noexcept : Type(theOther.Type), Value(theOther.Value)
+			{
+				theOther.Type = empty;
+			}
+			FlatCellValue(const std::string&);
+			FlatCellValue(const std::wstring&);
+			FlatCellValue(double Number) : Type(number)
+			{
+				Value.Number = Number;
+			}
+			FlatCellValue(unsigned long Code, bool Error=false); //Error = true if you want an error code
+			FlatCellValue(bool TrueFalse) : Type(boolean)
+			{
+				Value.Number = 0.0;
+				Value.Flag = TrueFalse;
+			}
+			FlatCellValue(int i) : Type(number)
+			{
+				Value.Number = i;
+			}
+
+			~FlatCellValue()
+			{
+				if (HasText())
+					delete Value.String;
+			}
+
+			FlatCellValue &operator=(const FlatCellValue &theOther)
+			{
+				FlatCellValue(theOther).swap(*this);
+				return *this;
+			}
+			FlatCellValue &operator=(FlatCellValue &&theOther) noexcept
+			{
+				FlatCellValue(std::move(theOther)).swap(*this);
+				return *this;
+			}
+
+			const std::string & StringValue() const;
+			const std::wstring& WstringValue() const;
+			double NumericValue() const;
+			bool BooleanValue() const;
+			unsigned long ErrorValue() const;
+
+			operator std::string() const;
+			operator std::wstring() const;
+			operator bool() const;
+			operator double() const;
+			operator unsigned long() const;
+
+			void clear()
+			{
+				FlatCellValue().swap(*this);
+			}
+
+			void swap(FlatCellValue &theOther) // This Does not and SHOULD NOT throw
+			{
+				std::swap(Type,theOther.Type);
+				std::swap(Value,theOther.Value);
+			}
+
+
+			FlatCellValue & assign(const std::string &data)
+			{
+				FlatCellValue(data).swap(*this);
+				return *this;
+			}
+			FlatCellValue & assign(const std::wstring& data)
+			{
+				FlatCellValue(data).swap(*this);
+				return *this;
+			}
+			FlatCellValue & assign(double data)
+			{
+				FlatCellValue(data).swap(*this);
+				return *this;
+			}
+			FlatCellValue & assign(unsigned long data)
+			{
+				FlatCellValue(data).swap(*this);
+				return *this;
+			}
+			FlatCellValue & assign(bool data)
+			{
+				FlatCellValue(data).swap(*this);
+				return *this;
+			}
+			FlatCellValue & assign(int data)
+			{
+				FlatCellValue(data).swap(*this);
+				return *this;
+			}
+			FlatCellValue & assign(error_type e)
+			{
+				FlatCellValue(e.value,true).swap(*this);
+				return *this;
+			}
+		};
+
+		/// Cell matrix keeping all its cells in a single row major block
+		/**
+		Element access is unchecked unless _DEBUG is defined, when it throws
+		XlfOutOfBounds like NCMatrix does. Select it by changing the
+		CellMatrixImpl typedef in MyContainers.h.
+		*/
+		class FlatCellMatrix : public CellMatrix_pimpl_abstract
+		{
+		public:
+			FlatCellMatrix();
+			FlatCellMatrix(size_t rows, size_t columns);
+
+			const CellValue& operator()(size_t i, size_t j) const
+			{
+				check(i, j);
+				return Cells[i * Columns + j];
+			}
+			CellValue& operator()(size_t i, size_t j)
+			{
+				check(i, j);
+				return Cells[i * Columns + j];
+			}
+
+			size_t RowsInStructure() const
+			{
+				return Rows;
+			}
+			size_t ColumnsInStructure() const
+			{
+				return Columns;
+			}
+
+			void PushBottom(const CellMatrix_pimpl_abstract& newRows);
+			void AppendRows(size_t rows);
+			void Reserve(size_t rows);
+
+			/// strings convert through an atomic pointer, so const reads are safe from any thread
+			bool IsSafeToShare() const
+			{
+				return true;
+			}
+
+		private:
+			/// lays the rows out again for a larger number of columns
+			void Widen(size_t newColumns);
+
+			void check(size_t i, size_t j) const
+			{
+#ifdef _DEBUG
+				if (i >= Rows || j >= Columns)
+					throw XlfOutOfBounds();
+#else
+				(void)i;
+				(void)j;
+#endif
+			}
+
+			std::vector<FlatCellValue> Cells;
+			size_t Rows;
+			size_t Columns;
+			/// rows asked for by Reserve, kept as the number of columns may not be known yet
+			size_t ReservedRows;
+
+		};
+
+
+	}
+}
+
+#endif // FLAT_CELL_MATRIX_H
@@ -29,6 +29,7 @@ FOR A PARTICULAR PURPOSE.  See the license for more details.
 #include <xlw/CellMatrixPimpl.h>
 #include <string>
 #include <vector>
+#include <atomic>
 
 namespace xlw {
 
@@ -44,12 +45,25 @@ namespace xlw {
 			};
 			ValueType Type;
 
-			mutable std::shared_ptr<std::string>  ValueAsString;
-			mutable std::shared_ptr<std::wstring> ValueAsWstring;
-			double ValueAsNumeric;
-			bool ValueAsBool;
-
-			unsigned long ValueAsErrorCode;
+			union
+			{
+				double Numeric;
+				unsigned long ErrorCode;
+				bool Bool;
+			} Value;
+
+			/// every string is held as UTF-16, short ones fit inside the string itself
+			/**
+			Narrow strings are widened a byte at a time so that the bytes
+			given can be handed back unchanged.
+			*/
+			std::wstring ValueAsWstring;
+			/// narrow form of the string, only made when asked for
+			/**
+			Const cells may be read from several threads at once, so it is
+			published with a compare and swap and the loser throws its copy away.
+			*/
+			mutable std::atomic<std::string*> ValueAsString;
 
 		public:
 			/// is value an ascii string type
@@ -64,6 +78,13 @@ namespace xlw {
 			bool IsEmpty() const;
 
 			MJCellValue(const MJCellValue &);
+			//! leaves theOther empty, noexcept so vectors of cells move rather than copy when they grow
+			MJCellValue(MJCellValue &&theOther) noexcept : Type(theOther.Type), Value(theOther.Value),
+				ValueAsWstring(std::move(theOther.ValueAsWstring)), ValueAsString(theOther.ValueAsString.exchange(0))
+			{
+				theOther.Type = empty;
+			}
+			~MJCellValue();
 			MJCellValue(const std::string&);
 			MJCellValue(const std::wstring&);
 			MJCellValue(double Number);
@@ -78,6 +99,11 @@ namespace xlw {
 				MJCellValue(theOther).swap(*this);
 				return *this;
 			}
+			MJCellValue &operator=(MJCellValue &&theOther) noexcept
+			{
+				MJCellValue(std::move(theOther)).swap(*this);
+				return *this;
+			}
 
 			const std::string & StringValue() const;
 			const std::wstring& WstringValue() const;
@@ -98,11 +124,9 @@ namespace xlw {
 
 			void swap(MJCellValue &theOther) // This Does not and SHOULD NOT throw
 			{
-				ValueAsString.swap(theOther.ValueAsString);
+				ValueAsString.store(theOther.ValueAsString.exchange(ValueAsString.load()));
 				ValueAsWstring.swap(theOther.ValueAsWstring);
-				std::swap(ValueAsNumeric,theOther.ValueAsNumeric);
-				std::swap(ValueAsBool,theOther.ValueAsBool);
-				std::swap(ValueAsErrorCode,theOther.ValueAsErrorCode);
+				std::swap(Value,theOther.Value);
 				std::swap(Type,theOther.Type);
 
 			}
@@ -155,6 +179,14 @@ namespace xlw {
 				Rows = theOther.Rows;
 				Columns = theOther.Columns;
 			}
+			MJCellMatrix(MJCellMatrix &&theOther)
+				: Cells(std::move(theOther.Cells)), Rows(theOther.Rows), Columns(theOther.Columns)
+			{
+				theOther.Rows = 0;
+				theOther.Columns = 0;
+			}
+			MJCellMatrix &operator=(const MJCellMatrix &) = default;
+			MJCellMatrix &operator=(MJCellMatrix &&) = default;
 			MJCellMatrix();
 			MJCellMatrix(size_t rows, size_t columns);
 
@@ -165,6 +197,14 @@ namespace xlw {
 			size_t ColumnsInStructure() const;
 
 			void PushBottom(const CellMatrix_pimpl_abstract& newRows);
+			void AppendRows(size_t rows);
+			void Reserve(size_t rows);
+
+			/// strings convert through an atomic pointer, so const reads are safe from any thread
+			bool IsSafeToShare() const
+			{
+				return true;
+			}
 
 		private:
 
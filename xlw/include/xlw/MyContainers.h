@@ -34,12 +34,20 @@
 // Uncomment the line below to use boost matrix
 //#define USE_XLW_WITH_BOOST_UBLAS
 
+// Uncomment the line below to keep all the cells of a CellMatrix in one block
+//#define USE_XLW_FLAT_CELL_MATRIX
+
+// Uncomment the line below to store the columns of a CellMatrix as typed arrays where possible
+//#define USE_XLW_COLUMNAR_CELL_MATRIX
+
 #ifndef _SCL_SECURE_NO_WARNINGS
 #define _SCL_SECURE_NO_WARNINGS
 #endif
 
 #include <xlw/NCMatrices.h>
 #include <xlw/MJCellMatrix.h>
+#include <xlw/FlatCellMatrix.h>
+#include <xlw/ColumnarCellMatrix.h>
 #include <vector>
 
 #ifdef USE_XLW_WITH_BOOST_UBLAS
@@ -71,7 +79,13 @@ namespace xlw {
 #endif
 
 
+#if defined(USE_XLW_FLAT_CELL_MATRIX)
+	typedef impl::FlatCellMatrix CellMatrixImpl;
+#elif defined(USE_XLW_COLUMNAR_CELL_MATRIX)
+	typedef impl::ColumnarCellMatrix CellMatrixImpl;
+#else
 	typedef impl::MJCellMatrix CellMatrixImpl;
+#endif
 
 
     template<typename MatrixType>
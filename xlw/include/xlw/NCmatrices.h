@@ -21,6 +21,7 @@ FOR A PARTICULAR PURPOSE.  See the license for more details.
 
 #include <cstddef>
 #include <vector>
+#include <utility>
 #include <xlw/eshared_ptr.h>
 #include <xlw/XlfException.h>
 
@@ -78,9 +79,13 @@ namespace xlw {
 
         explicit NCMatrix(size_t Rows_=0, size_t Cols_=0);
 
+        //! the data is shared until one of the matrices is changed
         NCMatrix(const NCMatrix& original);
+        //! takes over the data of original, leaving it an empty matrix
+        NCMatrix(NCMatrix&& original) noexcept;
 
         NCMatrix& operator=(const NCMatrix& original);
+        NCMatrix& operator=(NCMatrix&& original) noexcept;
 
 
         inline size_t rows() const;
@@ -92,6 +97,7 @@ namespace xlw {
 
         NCMatrix& resize(size_t rows, size_t columns);
 
+        //! use a const matrix to read, the non const accessors take a copy of shared data
         inline iterator operator[](size_t i);
         inline const_iterator operator[](size_t i) const;
 
@@ -101,16 +107,24 @@ namespace xlw {
         // We have added to the interface here 28-03-2011
         // but swap is generally an accepted method in container
         // interfaces
-        inline void swap(NCMatrix& theOther);// this cannot throw !
+        inline void swap(NCMatrix& theOther) noexcept;// this cannot throw !
 
         ~NCMatrix(){}
 
     private:
         inline void check_row(size_t j)const;
         inline void check_column(size_t i)const;
+        //! the data moved-from matrices share
+        static const eshared_ptr<NCMatrixData>& emptyData();
+        //! takes a copy of the data if another matrix is sharing it
+        inline void unshare();
+        //! as unshare, then stops the data being shared as a reference into it is being handed out
+        inline void leak();
 
 
         eshared_ptr<NCMatrixData> theData;
+        //! false once a reference into the data has been handed out
+        bool shareable;
 
     };
 
@@ -141,6 +155,7 @@ namespace xlw {
 
     double& NCMatrix::operator()(size_t i, size_t j)
     {
+        leak();
         check_row(i);
         check_column(j);
         return theData->theRows[i][j];
@@ -156,6 +171,7 @@ namespace xlw {
 
     NCMatrix::iterator  NCMatrix::operator[](size_t i)
     {
+        leak();
         check_row(i);
         return theData->theRows[i];
     }
@@ -187,6 +203,7 @@ namespace xlw {
         if (addend.rows() != rows() || addend.columns() != columns())
             throw XlfGeneralException("bad matrix addition");
 #endif
+        unshare();
 
         NCMatrix::iterator i = theData->theArray.begin();
         NCMatrix::const_iterator j = addend.theData->theArray.begin();
@@ -200,9 +217,25 @@ namespace xlw {
 
     }
 
-    void NCMatrix::swap(NCMatrix& theOther) // this cannot throw !
+    void NCMatrix::swap(NCMatrix& theOther) noexcept // this cannot throw !
     {
         theData.swap(theOther.theData);
+        std::swap(shareable, theOther.shareable);
+    }
+
+    void NCMatrix::unshare()
+    {
+        if (theData.use_count() > 1)
+            theData = theData.copy();
+    }
+
+    void NCMatrix::leak()
+    {
+        if (shareable)
+        {
+            unshare();
+            shareable = false;
+        }
     }
 
 }
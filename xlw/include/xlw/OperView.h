@@ -0,0 +1,336 @@
+/*
+ This file is part of XLW, a free-software/open-source C++ wrapper of the
+ Excel C API - https://xlw.github.io/
+
+ XLW is free software: you can redistribute it and/or modify it under the
+ terms of the XLW license.  You should have received a copy of the
+ license along with this program; if not, please email xlw-users@lists.sf.net
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#ifndef INC_OperView_H
+#define INC_OperView_H
+
+/*!
+\file OperView.h
+\brief Declares class OperView.
+*/
+
+// $Id$
+
+#include <xlw/XlfOper.h>
+#include <xlw/XlfException.h>
+#include <string>
+#include <iterator>
+#include <cstddef>
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+namespace xlw {
+
+    //! Read only view of the elements of an array passed in from Excel
+    /*!
+    Reads straight from the XLOPER12 Excel passed in so nothing is copied
+    and no temporary memory is used. The view is only valid for the
+    duration of the call it was given to. A value that isn't an array is
+    viewed as a 1x1 array, references must be coerced to values first,
+    which Excel does for arguments registered as XLF_OPER.
+
+    \code
+    double sumFirstColumn(const OperView& values)
+    {
+        OperView::Range column(values.Column(0));
+        double sum = 0.0;
+        for(size_t i = 0; i < column.size(); ++i)
+            sum += column.AsDouble(i);
+        return sum;
+    }
+    \endcode
+    */
+    class OperView
+    {
+    public:
+        //! Evenly spaced elements of a view, such as a row or a column
+        class Range
+        {
+        public:
+            class const_iterator
+            {
+            public:
+                typedef std::forward_iterator_tag iterator_category;
+                typedef XLOPER12 value_type;
+                typedef std::ptrdiff_t difference_type;
+                typedef const XLOPER12* pointer;
+                typedef const XLOPER12& reference;
+
+                const_iterator(const XLOPER12* element, std::ptrdiff_t stride) : element_(element), stride_(stride) {}
+                reference operator*() const { return *element_; }
+                pointer operator->() const { return element_; }
+                const_iterator& operator++() { element_ += stride_; return *this; }
+                const_iterator operator++(int) { const_iterator result(*this); element_ += stride_; return result; }
+                bool operator==(const const_iterator& other) const { return element_ == other.element_; }
+                bool operator!=(const const_iterator& other) const { return element_ != other.element_; }
+            private:
+                const XLOPER12* element_;
+                std::ptrdiff_t stride_;
+            };
+
+            Range(const XLOPER12* first, size_t count, std::ptrdiff_t stride) :
+                first_(first), count_(count), stride_(stride)
+            {
+            }
+
+            size_t size() const
+            {
+                return count_;
+            }
+            const XLOPER12& operator[](size_t i) const
+            {
+                return first_[static_cast<std::ptrdiff_t>(i) * stride_];
+            }
+            const_iterator begin() const
+            {
+                return const_iterator(first_, stride_);
+            }
+            const_iterator end() const
+            {
+                return const_iterator(first_ + static_cast<std::ptrdiff_t>(count_) * stride_, stride_);
+            }
+
+            bool IsNumber(size_t i) const
+            {
+                return ((*this)[i].xltype & 0xFFF) == xltypeNum;
+            }
+            double AsDouble(size_t i, const char* ErrorId = 0) const
+            {
+                return OperView::ElementAsDouble((*this)[i], ErrorId);
+            }
+
+            //! True when every element is a number
+            bool IsAllNumbers() const
+            {
+                size_t i = 0;
+                while(i != count_)
+                {
+                    // accumulate without branching within a block so the
+                    // compiler can unroll the scan
+                    size_t blockEnd = std::min<size_t>(count_, i + 64);
+                    DWORD mismatch = 0;
+                    for(; i != blockEnd; ++i)
+                    {
+                        mismatch |= ((*this)[i].xltype & 0xFFF) ^ xltypeNum;
+                    }
+                    if(mismatch)
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            //! Copies the elements into out, which must hold size() values
+            void CopyNumbers(double* out, const char* ErrorId = 0) const
+            {
+                if(IsAllNumbers())
+                {
+                    for(size_t i = 0; i < count_; ++i)
+                    {
+                        out[i] = (*this)[i].val.num;
+                    }
+                }
+                else
+                {
+                    for(size_t i = 0; i < count_; ++i)
+                    {
+                        out[i] = AsDouble(i, ErrorId);
+                    }
+                }
+            }
+
+        private:
+            const XLOPER12* first_;
+            size_t count_;
+            std::ptrdiff_t stride_;
+        };
+
+        //! Views a value passed in from Excel
+        OperView(LPXLOPER12 oper)
+        {
+            switch(oper->xltype & 0xFFF)
+            {
+            case xltypeMulti:
+                elements_ = oper->val.array.lparray;
+                rows_ = oper->val.array.rows;
+                columns_ = oper->val.array.columns;
+                break;
+
+            case xltypeSRef:
+            case xltypeRef:
+                THROW_XLW("OperView needs a value, not a reference");
+                break;
+
+            default:
+                elements_ = oper;
+                rows_ = 1;
+                columns_ = 1;
+                break;
+            }
+        }
+
+        //! \name Shape
+        //@{
+        size_t rows() const
+        {
+            return rows_;
+        }
+        size_t columns() const
+        {
+            return columns_;
+        }
+        size_t size() const
+        {
+            return rows_ * columns_;
+        }
+        //@}
+
+        //! \name Element access
+        //@{
+        const XLOPER12& operator()(size_t row, size_t col) const
+        {
+            return elements_[row * columns_ + col];
+        }
+        DWORD XlType(size_t row, size_t col) const
+        {
+            return (*this)(row, col).xltype & 0xFFF;
+        }
+        bool IsNumber(size_t row, size_t col) const
+        {
+            return XlType(row, col) == xltypeNum;
+        }
+        bool IsString(size_t row, size_t col) const
+        {
+            return XlType(row, col) == xltypeStr;
+        }
+        bool IsBool(size_t row, size_t col) const
+        {
+            return XlType(row, col) == xltypeBool;
+        }
+        bool IsError(size_t row, size_t col) const
+        {
+            return XlType(row, col) == xltypeErr;
+        }
+        bool IsNil(size_t row, size_t col) const
+        {
+            return XlType(row, col) == xltypeNil;
+        }
+        bool IsMissing(size_t row, size_t col) const
+        {
+            return XlType(row, col) == xltypeMissing;
+        }
+        //! Numbers, booleans and integers, anything else throws
+        double AsDouble(size_t row, size_t col, const char* ErrorId = 0) const
+        {
+            return ElementAsDouble((*this)(row, col), ErrorId);
+        }
+        bool AsBool(size_t row, size_t col, const char* ErrorId = 0) const
+        {
+            const XLOPER12& element((*this)(row, col));
+            switch(element.xltype & 0xFFF)
+            {
+            case xltypeBool:
+                return !!element.val.xbool;
+            case xltypeNum:
+                return element.val.num != 0.0;
+            case xltypeInt:
+                return element.val.w != 0;
+            default:
+                ThrowWrongType(element, ErrorId, "Conversion to Bool");
+                throw XlfNeverGetHere();
+            }
+        }
+        std::wstring AsWstring(size_t row, size_t col, const char* ErrorId = 0) const
+        {
+            const XLOPER12& element((*this)(row, col));
+            if((element.xltype & 0xFFF) != xltypeStr)
+            {
+                ThrowWrongType(element, ErrorId, "Conversion to WString");
+            }
+            return std::wstring(element.val.str + 1, element.val.str + 1 + element.val.str[0]);
+        }
+        int ErrorValue(size_t row, size_t col, const char* ErrorId = 0) const
+        {
+            const XLOPER12& element((*this)(row, col));
+            if((element.xltype & 0xFFF) != xltypeErr)
+            {
+                ThrowWrongType(element, ErrorId, "Conversion to Error");
+            }
+            return element.val.err;
+        }
+        //@}
+
+        //! \name Ranges
+        //@{
+        Range Row(size_t row) const
+        {
+            return Range(elements_ + row * columns_, columns_, 1);
+        }
+        Range Column(size_t col) const
+        {
+            return Range(elements_ + col, rows_, static_cast<std::ptrdiff_t>(columns_));
+        }
+        //! All elements in row major order
+        Range Elements() const
+        {
+            return Range(elements_, size(), 1);
+        }
+        //! count elements starting at index first in row major order, stepping by stride
+        Range Strided(size_t first, size_t count, std::ptrdiff_t stride) const
+        {
+            return Range(elements_ + first, count, stride);
+        }
+        //@}
+
+        //! True when every element is a number so values can be read without conversion
+        bool IsAllNumbers() const
+        {
+            return Elements().IsAllNumbers();
+        }
+
+    private:
+        static double ElementAsDouble(const XLOPER12& element, const char* ErrorId)
+        {
+            switch(element.xltype & 0xFFF)
+            {
+            case xltypeNum:
+                return element.val.num;
+            case xltypeBool:
+                return element.val.xbool ? 1.0 : 0.0;
+            case xltypeInt:
+                return element.val.w;
+            default:
+                ThrowWrongType(element, ErrorId, "Conversion to Double");
+                throw XlfNeverGetHere();
+            }
+        }
+        static void ThrowWrongType(const XLOPER12& element, const char* ErrorId, const char* identifier)
+        {
+            DWORD type(element.xltype & 0xFFF);
+            if(type == xltypeMissing || type == xltypeErr || type == xltypeNil)
+            {
+                XlfOperImpl::MissingOrEmptyError(type, ErrorId, identifier);
+            }
+            THROW_XLW(identifier << " failed for " << XlfOperImpl::XlTypeToString(type) << (ErrorId ? ", " : "") << (ErrorId ? ErrorId : ""));
+        }
+
+        const XLOPER12* elements_;
+        size_t rows_;
+        size_t columns_;
+    };
+}
+
+#endif
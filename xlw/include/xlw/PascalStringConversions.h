@@ -40,6 +40,8 @@ namespace xlw {
         static char* StringToPascalString(const std::string& cString);
         static char* WStringToPascalString(const std::wstring& cString);
         static char* WPascalStringToString(const wchar_t* pascalString);
+        //! As WPascalStringToString, setting length to the number of chars in the result
+        static char* WPascalStringToString(const wchar_t* pascalString, size_t& length);
         static std::wstring WPascalStringToWString(const wchar_t* pascalString);
         static wchar_t* StringToWPascalString(const std::string& cString);
         static wchar_t* WStringToWPascalString(const std::wstring& cString);
@@ -47,6 +49,34 @@ namespace xlw {
         static wchar_t* WPascalStringCopy(const wchar_t* pascalString);
         static char* PascalStringCopyUsingNew(const char* pascalString);
         static wchar_t* WPascalStringCopyUsingNew(const wchar_t* pascalString);
+
+        //! Copies n ASCII characters to wide characters, false if any isn't ASCII
+        /*!
+        Used to skip the code page conversion for the common case of plain
+        ASCII strings. When false is returned the output may be partly
+        written so the string should be converted the slow way.
+        */
+        static bool WidenAscii(const char* from, size_t n, wchar_t* to);
+        //! Copies n ASCII wide characters to chars, false if any isn't ASCII
+        static bool NarrowAscii(const wchar_t* from, size_t n, char* to);
+
+        //! \name UTF-8
+        //@{
+        //! Writes n UTF-16 characters as UTF-8 to to, which needs room for 3 * n bytes (4 * n with a 32 bit wchar_t)
+        /*!
+        Returns the number of bytes written. Unpaired surrogates become
+        U+FFFD so the result is always valid UTF-8.
+        */
+        static size_t Utf16ToUtf8(const wchar_t* from, size_t n, char* to);
+        //! Writes n bytes of UTF-8 as UTF-16 to to, which needs room for n characters
+        /*!
+        Returns the number of characters written. Invalid sequences become
+        U+FFFD.
+        */
+        static size_t Utf8ToUtf16(const char* from, size_t n, wchar_t* to);
+        static std::string WPascalStringToUtf8(const wchar_t* pascalString);
+        static wchar_t* Utf8ToWPascalString(const std::string& utf8String);
+        //@}
     };
 
     class StringUtilities
@@ -0,0 +1,92 @@
+/*
+ This file is part of XLW, a free-software/open-source C++ wrapper of the
+ Excel C API - https://xlw.github.io/
+
+ XLW is free software: you can redistribute it and/or modify it under the
+ terms of the XLW license.  You should have received a copy of the
+ license along with this program; if not, please email xlw-users@lists.sf.net
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#ifndef INC_StringPool_H
+#define INC_StringPool_H
+
+/*!
+\file StringPool.h
+\brief Declares class StringPool.
+*/
+
+// $Id$
+
+#include <string>
+#include <cstddef>
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+namespace xlw {
+
+    //! Process wide table giving each distinct string a 32 bit symbol
+    /*!
+    Interning the labels that repeat across large ranges, such as currency
+    codes or curve names, means each is stored once and cells holding them
+    only need the symbol. Two interned strings are equal exactly when their
+    symbols are, so symbols can be compared and hashed instead of the text.
+
+    Strings are never removed and the memory they take is never given back
+    until the process ends, so only intern values drawn from a limited set.
+    Once the pool is full cells keep their own copy of new strings instead.
+    Only interning a new string takes a lock, interning one already in the
+    pool or looking up a symbol doesn't.
+
+    \code
+    StringPool::InternCellStrings(true);
+    // wide strings put into a FlatCellMatrix or ColumnarCellMatrix,
+    // including those read by XlfOper::AsCellMatrix, are now interned
+    \endcode
+    */
+    class StringPool
+    {
+    public:
+        //! Identifies an interned string, never 0
+        typedef unsigned int Symbol;
+
+        //! \name Interning
+        //@{
+        //! The symbol for text, adding it to the pool if it is new, throws if the pool is full
+        static Symbol Intern(const wchar_t* text, size_t length);
+        static Symbol Intern(const std::wstring& text)
+        {
+            return Intern(text.data(), text.size());
+        }
+        //! As Intern but gives 0 rather than throwing when the pool is full
+        static Symbol TryIntern(const wchar_t* text, size_t length);
+        static Symbol TryIntern(const std::wstring& text)
+        {
+            return TryIntern(text.data(), text.size());
+        }
+        //! The string a symbol stands for
+        static const std::wstring& WstringValue(Symbol symbol);
+        //! The string narrowed a character at a time, made the first time it is asked for
+        static const std::string& StringValue(Symbol symbol);
+        //! Number of strings in the pool
+        static size_t Size();
+        //@}
+
+        //! \name Use by cells
+        //@{
+        //! Sets whether cells that support it intern wide strings assigned to them
+        static void InternCellStrings(bool intern);
+        static bool InternsCellStrings();
+        //@}
+
+    private:
+        StringPool();
+    };
+}
+
+#endif
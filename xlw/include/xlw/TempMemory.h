@@ -30,6 +30,8 @@
 // $Id$
 
 #include <list>
+#include <vector>
+#include <atomic>
 
 #if defined(_MSC_VER)
 #pragma once
@@ -54,12 +56,26 @@ namespace xlw {
         //! \name Memory management
         //@{
         //! Allocates memory in the framework temporary buffer
+        /*!
+        The whole block is zeroed, large ones included, so prefer
+        GetMemoryUninitialized for arrays that are about to be filled.
+        */
         template<typename TYPE>
         static TYPE* GetMemory(size_t numItems = 1)
         {
             return reinterpret_cast<TYPE*>(GetBytes(numItems * sizeof(TYPE)));
         }
 
+        //! Allocates memory in the framework temporary buffer without zeroing it
+        /*!
+        Only use this when every byte of the block is about to be written.
+        */
+        template<typename TYPE>
+        static TYPE* GetMemoryUninitialized(size_t numItems = 1)
+        {
+            return reinterpret_cast<TYPE*>(GetBytesUninitialized(numItems * sizeof(TYPE)));
+        }
+
 		//! Allocates memory using new operator
         template<typename TYPE>
         static TYPE* GetMemoryUsingNew(size_t numItems = 1)
@@ -80,16 +96,74 @@ namespace xlw {
             delete [] pointerToFree;
         }
 
+        //! Position in the calling thread's temporary buffer
+        struct Mark
+        {
+            TempMemory* instance;
+            size_t buffers;
+            size_t offset;
+            size_t filledBytes;
+            size_t largeSequence;
+            size_t resets;
+        };
+        //! Records the current position so it can be rolled back to
+        static Mark GetMark();
+        //! Releases everything allocated since the mark was taken
+        /*!
+        Marks must be rolled back in the reverse order they were taken
+        and nothing allocated since must be used afterwards.
+        \sa TempMemoryScope
+        */
+        static void RollbackToMark(const Mark& mark);
+
         //! To be called to setup TempMemory
         static void InitializeProcess();
         //! To be called to clean up TempMemory
         static void TerminateProcess();
         //@}
 
-        //! \name Utilities
+        //! Usage counters for the temporary memory arena
+        /*!
+        Counters accumulate from creation of the arena or from the last
+        call to ResetStatistics. A call is the span between entering and
+        leaving the outermost exported function.
+        */
+        struct Statistics
+        {
+            Statistics() : allocations(0), bytesAllocated(0), bufferPushes(0),
+                calls(0), peakCallBytes(0), retainedBytes(0),
+                largeRegionsMapped(0), largeRetainedBytes(0) {}
+            //! Number of requests for memory
+            size_t allocations;
+            //! Total bytes handed out
+            size_t bytesAllocated;
+            //! Number of times a new buffer had to be allocated
+            size_t bufferPushes;
+            //! Number of completed calls
+            size_t calls;
+            //! Most bytes used by a single call
+            size_t peakCallBytes;
+            //! Capacity currently kept between calls
+            size_t retainedBytes;
+            //! Number of times a region for a large allocation had to be mapped
+            size_t largeRegionsMapped;
+            //! Capacity of large regions currently kept between calls
+            size_t largeRetainedBytes;
+        };
+
+        //! \name Telemetry
         //@{
-        //! Has this thread stopped
-        bool isThreadDead() const;
+        //! Counters for the calling thread's arena
+        static Statistics GetThreadStatistics();
+        //! Counters summed over every arena in the process
+        /*!
+        peakCallBytes is the largest peak of any single arena.
+        Values are read without synchronising with the owning threads
+        so may be slightly stale.
+        */
+        static Statistics GetProcessStatistics();
+        //! Clears the counters for the calling thread's arena
+        static void ResetStatistics();
         //@}
 
     private:
@@ -102,14 +176,33 @@ namespace xlw {
 
         //! Allocates memory in the framework temporary buffer
         static char* GetBytes(size_t bytes);
+        static char* GetBytesUninitialized(size_t bytes);
 
         char* InternalGetMemory(size_t bytes);
         //! Frees temporary memory used by the XLL
         void InternalFreeMemory(bool finished=false);
         void InternalEnterExportedFunction();
         void InternalLeaveExportedFunction();
+        void InternalRollbackToMark(const Mark& mark);
+        //! The instance belonging to the calling thread, created on first use
+        static TempMemory* ThreadInstance();
         static TempMemory* CreateTempMemory();
 
+        //! Hands the calling thread's instance back for reuse when the thread exits
+        struct ThreadOwner
+        {
+            ThreadOwner() : instance(0) {}
+            ~ThreadOwner();
+            TempMemory* instance;
+        };
+
+        //! Fast lookup of the calling thread's instance, constant initialised so needs no guard
+        static thread_local TempMemory* threadInstance_;
+        //! Only touched when an instance is claimed so that the thread exit destructor is registered
+        static thread_local ThreadOwner threadOwner_;
+        //! Head of the process wide list of instances, only ever pushed onto so it can be walked without a lock
+        static std::atomic<TempMemory*> instances_;
+
         //! Memory buffer used to store data that are passed to Excel
         /*!
         When we pass XLOPER from the XLL towards Excel we should not use
@@ -139,13 +232,89 @@ namespace xlw {
         BufferList freeList_;
         //! Pointer to next free area (excluded from the pimpl to allow inlining).
         size_t offset_;
-        //! Thread Id that this object belongs to
-        DWORD threadId_;
+        //! Bytes used in buffers already filled during this call
+        size_t filledBytes_;
+        //! Capacity to keep between calls, decays towards recent usage
+        size_t retainTarget_;
+        //! Most bytes used in the buffers during this call before a rollback
+        size_t callPeakBytes_;
+        //! Number of times the buffers have been reset, so stale marks can be ignored
+        size_t resets_;
         //! Recurse depth
         int depth_;
+        //! Next instance in the process wide list
+        TempMemory* next_;
+        //! Set while a live thread owns this instance
+        std::atomic<bool> inUse_;
+
+        //! Counters are only written by the owning thread
+        //! but are atomic so that other threads may read them
+        struct Counters
+        {
+            Counters();
+            std::atomic<size_t> allocations;
+            std::atomic<size_t> bytesAllocated;
+            std::atomic<size_t> bufferPushes;
+            std::atomic<size_t> calls;
+            std::atomic<size_t> peakCallBytes;
+            std::atomic<size_t> retainedBytes;
+            std::atomic<size_t> largeRegionsMapped;
+            std::atomic<size_t> largeRetainedBytes;
+        };
+        Counters counters_;
+        Statistics InternalGetStatistics() const;
+        void InternalResetStatistics();
+
+        //! Size of the first buffer allocated and smallest buffer kept
+        static const size_t InitialBufferSize = 8192;
 
         //! Create a new static buffer and add it to the free list.
         void PushNewBuffer(size_t);
+
+        //! A region mapped for a single large allocation
+        /*!
+        Large results, such as whole sheet arrays, get their own region
+        rather than growing the buffer chain. Regions are kept across calls
+        and reused by later allocations that fit, so that the cost of
+        mapping and faulting in the pages isn't paid on every recalculation,
+        and are only released once they have gone unused for a while.
+        */
+        struct LargeRegion
+        {
+            //! Start address.
+            char* start;
+            //! Size of the mapping.
+            size_t size;
+            //! Set while handed out during the current call.
+            bool inUse;
+            //! Number of calls since the region was last used.
+            unsigned int idleCalls;
+            //! Bytes handed out from the region.
+            size_t used;
+            //! Order in which the region was handed out, used to roll back to a mark.
+            size_t sequence;
+        };
+        typedef std::vector<LargeRegion> LargeRegionList;
+        //! Regions for large allocations, both in use and held for reuse
+        LargeRegionList largeRegions_;
+        //! Bytes handed out from large regions during this call
+        size_t largeBytesInCall_;
+        //! Incremented each time a large region is handed out
+        size_t largeSequence_;
+
+        char* InternalGetLargeMemory(size_t bytes);
+        //! Marks regions free, releasing those unused for too long or all when finished
+        void ReleaseLargeRegions(bool finished);
+        //! Maps a region of at least size bytes using large pages when we can, size is updated to the size mapped
+        static char* MapRegion(size_t& size);
+        static void UnmapRegion(char* start);
+        //! Set once large pages have been refused so we don't keep asking
+        static std::atomic<bool> largePagesUnavailable_;
+
+        //! Allocations of at least this many bytes are served from large regions
+        static const size_t LargeAllocationThreshold = 4 * 1024 * 1024;
+        //! Number of calls a large region may go unused before it is released
+        static const unsigned int LargeRegionIdleCalls = 16;
     };
 
     //! RAII class to signal that we are using Temporary memory
@@ -161,6 +330,35 @@ namespace xlw {
             TempMemory::LeaveExportedFunction();
         }
     };
+
+    //! RAII class that releases temporary memory allocated during its lifetime
+    /*!
+    Used around scratch work, such as converting elements of a range one
+    at a time, so that memory use doesn't grow with the number of
+    iterations. Nothing allocated from TempMemory while the scope is alive
+    may be used once it has been rolled back, so results must be copied
+    out first.
+    */
+    class TempMemoryScope
+    {
+    public:
+        TempMemoryScope() : mark_(TempMemory::GetMark())
+        {
+        }
+        ~TempMemoryScope()
+        {
+            TempMemory::RollbackToMark(mark_);
+        }
+        //! Releases everything allocated so far, the scope can carry on being used
+        void Rollback()
+        {
+            TempMemory::RollbackToMark(mark_);
+        }
+    private:
+        TempMemoryScope(const TempMemoryScope&);
+        TempMemoryScope& operator=(const TempMemoryScope&);
+        TempMemory::Mark mark_;
+    };
 }
 
 #define XLW_DLLMAIN_IMPL
@@ -0,0 +1,58 @@
+/*
+ This file is part of XLW, a free-software/open-source C++ wrapper of the
+ Excel C API - https://xlw.github.io/
+
+ XLW is free software: you can redistribute it and/or modify it under the
+ terms of the XLW license.  You should have received a copy of the
+ license along with this program; if not, please email xlw-users@lists.sf.net
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#ifndef INC_Utf8String_H
+#define INC_Utf8String_H
+
+/*!
+\file Utf8String.h
+\brief Declares class Utf8String.
+*/
+
+// $Id$
+
+#include <string>
+#include <utility>
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+namespace xlw {
+
+    //! A std::string holding UTF-8 text
+    /*!
+    Arguments and results of this type are converted straight between
+    Excel's UTF-16 and UTF-8, so unlike std::string, which goes through
+    the ANSI code page, no characters are lost. Being a std::string it can
+    be passed on to anything expecting one.
+    */
+    class Utf8String : public std::string
+    {
+    public:
+        Utf8String()
+        {
+        }
+        Utf8String(const std::string& value) : std::string(value)
+        {
+        }
+        Utf8String(std::string&& value) : std::string(std::move(value))
+        {
+        }
+        Utf8String(const char* value) : std::string(value)
+        {
+        }
+    };
+}
+
+#endif
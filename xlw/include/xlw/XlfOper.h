@@ -33,8 +33,10 @@
 #include <xlw/XlfOperProperties.h>
 #include <xlw/CellMatrix.h>
 #include <xlw/XlfRef.h>
+#include <xlw/Utf8String.h>
 #include <vector>
 #include <string>
+#include <functional>
 
 #if defined(_MSC_VER)
 #pragma once
@@ -59,6 +61,32 @@ namespace xlw {
         static void ThrowOnError(int, const char* ErrorId = 0, const char* identifier = 0);
         static void MissingOrEmptyError(int xlType, const char* ErrorId = 0, const char* identifier = 0);
         static std::string XlTypeToString(int xlType);
+
+        //! Records Excel callbacks avoided by coercing a whole range at once
+        static void AddCoerceCallbacksSaved(size_t saved);
+        //! Number of Excel callbacks avoided so far by coercing whole ranges
+        static size_t CoerceCallbacksSaved();
+
+        //! Calls fill(firstRow, endRow) for bands of rows that together cover all the rows
+        /*!
+        Once rows * columns reaches ParallelFillThreshold() the bands are
+        shared between the calling thread and a pool of worker threads, so
+        fill must only write to its own rows and must not use TempMemory,
+        which belongs to the calling thread.
+        */
+        static void FillInBands(size_t rows, size_t columns, const std::function<void(size_t, size_t)>& fill);
+        //! Makes oper an array holding the values in cells
+        /*!
+        The elements and all the strings are put in a single block of
+        temporary memory, sized by a first pass over the cells, see
+        ArrayPacker. Large matrices are filled in bands as FillInBands does.
+        */
+        static void SetCellMatrix(LPXLOPER12 oper, const CellMatrix& cells);
+        //! Sets the number of cells from which array results are filled by several threads, 0 for never
+        static void SetParallelFillThreshold(size_t cells);
+        static size_t ParallelFillThreshold();
+        //! Joins the threads bands are filled on, they are started again when next needed
+        static void StopFillThreads();
     };
 }
 
@@ -106,6 +134,27 @@ namespace xlw {
             }
         }
 
+        // Coercing a reference to a multi in one go gives blank cells as xltypeNil,
+        // whereas coercing each cell to a number on its own gives 0.
+        // The numeric accessors read blanks as 0 whichever way they go,
+        // so this must not change without changing that behaviour on purpose.
+        static void blanksToZero(OperType& multi)
+        {
+            MultiRowType nbRows(OperProps::getRows(&multi));
+            MultiColType nbCols(OperProps::getCols(&multi));
+            for(MultiRowType row(0); row < nbRows; ++row)
+            {
+                for(MultiColType col(0); col < nbCols; ++col)
+                {
+                    LPXLOPER12 element(OperProps::getElement(&multi, row, col));
+                    if((OperProps::getXlType(element) & 0xFFF) == xltypeNil)
+                    {
+                        OperProps::setDouble(element, 0.0);
+                    }
+                }
+            }
+        }
+
     public:
 
         //! \name Array settor
@@ -119,14 +168,18 @@ namespace xlw {
         template <class FwdIt>
         void Set(RW rows, COL cols, FwdIt start)
         {
-            OperProps::setArraySize(lpxloper_, rows, cols);
+            OperProps::setArraySize(lpxloper_, rows, cols, false);
             RW actualrows = OperProps::getRows(lpxloper_);
             COL actualcols = OperProps::getCols(lpxloper_);
             for(MultiRowType row(0); row < actualrows; ++row)
             {
                 for(MultiRowType col(0); col < actualcols; ++col)
                 {
-                    XlfOper cellToSet(OperProps::getElement(lpxloper_, row, col));
+                    // the array isn't zeroed so give the element a type before
+                    // wrapping it, ~XlfOper reads it if the assignment throws
+                    LPXLOPER12 element(OperProps::getElement(lpxloper_, row, col));
+                    OperProps::setXlType(element, xltypeNil);
+                    XlfOper cellToSet(element);
                     cellToSet = *start++;
                 }
                 start += (cols - actualcols);
@@ -148,6 +201,18 @@ namespace xlw {
         {
             OperProps::copy(oper.lpxloper_, lpxloper_);
         }
+        //! Move ctor.
+        /*!
+        Takes over the XLOPER of oper so that arrays and strings aren't
+        copied. oper is left holding a missing value.
+        */
+        XlfOper(XlfOper&& oper) :
+            lpxloper_(oper.lpxloper_)
+        {
+            // the source still gets destroyed so must not see any memory it could free
+            oper.lpxloper_ = TempMemory::GetMemory<OperType>();
+            OperProps::setXlType(oper.lpxloper_, xltypeMissing);
+        }
 
         //! LPXLOPER/LPXLOPER12 ctor.
         XlfOper(LPXLOPER12 lpxloper) :
@@ -190,47 +255,7 @@ namespace xlw {
         XlfOper(const CellMatrix& cellmatrix) :
             lpxloper_(TempMemory::GetMemory<OperType>())
         {
-            RW nbRows = (RW)cellmatrix.RowsInStructure();
-            COL nbCols = (COL)cellmatrix.ColumnsInStructure();
-
-            OperProps::setArraySize(lpxloper_, nbRows, nbCols);
-
-            // get actual number of rows in case of truncation
-            nbRows = OperProps::getRows(lpxloper_);
-            nbCols = OperProps::getCols(lpxloper_);
-
-            for (RW row(0); row < nbRows; ++row)
-            {
-                for (COL col(0); col < nbCols; ++col)
-                {
-                    LPXLOPER12 elementOper = OperProps::getElement(lpxloper_, row, col);
-                    const CellValue& cellValue(cellmatrix(row,col));
-                    if (cellValue.IsANumber())
-                    {
-                        OperProps::setDouble(elementOper, cellValue.NumericValue());
-                    }
-                    else if (cellValue.IsAString())
-                    {
-                        OperProps::setString(elementOper, cellValue.StringValue());
-                    }
-                    else if (cellValue.IsAWstring())
-                    {
-                        OperProps::setWString(elementOper, cellValue.WstringValue());
-                    }
-                    else if (cellValue.IsBoolean())
-                    {
-                        OperProps::setBool(elementOper, cellValue.BooleanValue());
-                    }
-                    else if (cellValue.IsError())
-                    {
-                        OperProps::setError(elementOper, static_cast<short>(cellValue.ErrorValue()));
-                    }
-                    else
-                    {
-                        OperProps::setString(elementOper, "");
-                    }
-                }
-            }
+            XlfOperImpl::SetCellMatrix(lpxloper_, cellmatrix);
         }
 
         //! MyMatrix ctor.
@@ -240,20 +265,23 @@ namespace xlw {
             RW nbRows = (RW)MatrixTraits<MyMatrix>::rows(matrix);
             COL nbCols = (COL)MatrixTraits<MyMatrix>::columns(matrix);
 
-            OperProps::setArraySize(lpxloper_, nbRows, nbCols);
+            OperProps::setArraySize(lpxloper_, nbRows, nbCols, false);
 
             // get actual number of rows in case of truncation
             nbRows = OperProps::getRows(lpxloper_);
             nbCols = OperProps::getCols(lpxloper_);
 
-            for (RW row(0); row < nbRows; ++row)
+            XlfOperImpl::FillInBands(nbRows, nbCols, [this, &matrix, nbCols](size_t firstRow, size_t endRow)
             {
-                for (COL col(0); col < nbCols; ++col)
+                for (RW row((RW)firstRow); row < (RW)endRow; ++row)
                 {
-                    LPXLOPER12 elementOper = OperProps::getElement(lpxloper_, row, col);
-                    OperProps::setDouble(elementOper, MatrixTraits<MyMatrix>::getAt(matrix, row, col));
+                    for (COL col(0); col < nbCols; ++col)
+                    {
+                        LPXLOPER12 elementOper = OperProps::getElement(lpxloper_, row, col);
+                        OperProps::setDouble(elementOper, MatrixTraits<MyMatrix>::getAt(matrix, row, col));
+                    }
                 }
-            }
+            });
         }
 
         //! MyArray ctor.
@@ -262,7 +290,7 @@ namespace xlw {
         {
             RW nbRows = (RW)ArrayTraits<MyArray>::size(values);
 
-            OperProps::setArraySize(lpxloper_, nbRows, 1);
+            OperProps::setArraySize(lpxloper_, nbRows, 1, false);
 
             // get actual number of rows in case of truncation
             nbRows = OperProps::getRows(lpxloper_);
@@ -297,6 +325,12 @@ namespace xlw {
         {
             OperProps::setWString(lpxloper_, value);
         }
+        //!  UTF-8 string ctor.
+        XlfOper(const Utf8String& value) :
+            lpxloper_(TempMemory::GetMemory<OperType>())
+        {
+            OperProps::setUtf8String(lpxloper_, value);
+        }
         //!  XlfRef ctor.
         XlfOper(const XlfRef& value) :
             lpxloper_(TempMemory::GetMemory<OperType>())
@@ -420,6 +454,30 @@ namespace xlw {
         }
         //@}
 
+        //! Coerces a reference to a multi with a single call to Excel
+        /*!
+        Returns false when this isn't a reference or the coercion failed,
+        in which case the caller should carry on element by element.
+        The result is flagged to be freed by Excel so should be wrapped
+        in an XlfOper.
+        */
+        bool CoerceReferenceToMulti(OperType& multi) const
+        {
+            XlTypeType type(OperProps::getXlType(lpxloper_) & 0xFFF);
+            if(type != xltypeSRef && type != xltypeRef)
+            {
+                return false;
+            }
+            if(OperProps::coerce(lpxloper_, xltypeMulti, &multi) != xlretSuccess)
+            {
+                return false;
+            }
+            size_t cells((size_t)OperProps::getRows(&multi) * (size_t)OperProps::getCols(&multi));
+            // going element by element costs a coerce per cell
+            XlfOperImpl::AddCoerceCallbacksSaved(cells - 1);
+            return true;
+        }
+
         /*! \name Array Accessors / Operators
         These functions are used to access the elements of an array in an XlfOper
         whose underlying <tt>LPXLOPER/LPXLOPER12</tt> has <tt>xltype = xltypeMulti</tt>.
@@ -778,8 +836,105 @@ namespace xlw {
             }
         }
 
+#ifdef XLW_HAS_STRING_VIEW
+        //! Views the string without copying it
+        /*!
+        The view is of the string Excel passed in, or of a copy in
+        temporary memory when the value had to be coerced, so it may be
+        used until the function returns to Excel.
+        */
+        std::wstring_view AsWstringView(const char* ErrorId = 0) const
+        {
+            XlTypeType type(OperProps::getXlType(lpxloper_) & 0xFFF);
+            if(type == xltypeStr)
+            {
+                return OperProps::getWStringView(lpxloper_);
+            }
+            else
+            {
+                OperType stackMem;
+                int xlret = OperProps::coerce(lpxloper_, xltypeStr, &stackMem);
+                if(xlret == xlretSuccess)
+                {
+                    // Excel's copy is freed when result goes, so view a copy of our own
+                    XlfOper result(&stackMem);
+                    XlfOper copy(result);
+                    return copy.AsWstringView(ErrorId);
+                }
+                else
+                {
+                    xlw::XlfOperImpl::ThrowOnError(xlret, ErrorId, "Conversion to WString view");
+                    throw XlfNeverGetHere();
+                }
+            }
+        }
+
+        //! Converts to a string view over temporary memory
+        /*!
+        ASCII strings are narrowed without going through the code page.
+        The chars are in temporary memory, so may be used until the
+        function returns to Excel.
+        */
+        std::string_view AsStringView(const char* ErrorId = 0) const
+        {
+            XlTypeType type(OperProps::getXlType(lpxloper_) & 0xFFF);
+            if(type == xltypeStr)
+            {
+                return OperProps::getStringView(lpxloper_);
+            }
+            else
+            {
+                OperType stackMem;
+                int xlret = OperProps::coerce(lpxloper_, xltypeStr, &stackMem);
+                if(xlret == xlretSuccess)
+                {
+                    XlfOper result(&stackMem);
+                    return result.AsStringView(ErrorId);
+                }
+                else
+                {
+                    xlw::XlfOperImpl::ThrowOnError(xlret, ErrorId, "Conversion to String view");
+                    throw XlfNeverGetHere();
+                }
+            }
+        }
+#endif
+
+        //! Converts to a UTF-8 string.
+        Utf8String AsUtf8String(const char* ErrorId = 0) const
+        {
+            XlTypeType type(OperProps::getXlType(lpxloper_) & 0xFFF);
+            if(type == xltypeStr)
+            {
+                return OperProps::getUtf8String(lpxloper_);
+            }
+            else
+            {
+                OperType stackMem;
+                int xlret = OperProps::coerce(lpxloper_, xltypeStr, &stackMem);
+                if(xlret == xlretSuccess)
+                {
+                    XlfOper result(&stackMem);
+                    return result.AsUtf8String(ErrorId);
+                }
+                else
+                {
+                    xlw::XlfOperImpl::ThrowOnError(xlret, ErrorId, "Conversion to UTF-8 String");
+                    throw XlfNeverGetHere();
+                }
+            }
+        }
+
         std::vector<double> AsDoubleVector(const char* ErrorId = 0, XlfOperImpl::DoubleVectorConvPolicy policy = XlfOperImpl::UniDimensional) const
         {
+            OperType multi;
+            if(CoerceReferenceToMulti(multi))
+            {
+                blanksToZero(multi);
+                XlfOper coerced(&multi);
+                return coerced.AsDoubleVector(ErrorId, policy);
+            }
+
             std::vector<double> result;
             MultiRowType nbRows(OperProps::getRows(lpxloper_));
             MultiColType nbCols(OperProps::getCols(lpxloper_));
@@ -794,10 +949,21 @@ namespace xlw {
 
             result.resize(nbRows * nbCols);
 
+            if(OperProps::isNumericMulti(lpxloper_))
+            {
+                // nothing to convert so copy the values straight across
+                OperProps::copyNumericMulti(lpxloper_, &result[0], policy != XlfOperImpl::RowMajor);
+                return result;
+            }
+
+            // elements of references are allocated one at a time
+            // so release each once it has been converted
+            TempMemoryScope scratch;
             for(MultiRowType row(0); row < nbRows; ++row)
             {
                 for(MultiRowType col(0); col < nbCols; ++col)
                 {
+                    scratch.Rollback();
                     XlfOper element(OperProps::getElement(lpxloper_, row, col));
                     if(policy == XlfOperImpl::RowMajor)
                     {
@@ -814,6 +980,14 @@ namespace xlw {
 
         MyArray AsArray(const char* ErrorId = 0, XlfOperImpl::DoubleVectorConvPolicy policy = XlfOperImpl::UniDimensional) const
         {
+            OperType multi;
+            if(CoerceReferenceToMulti(multi))
+            {
+                blanksToZero(multi);
+                XlfOper coerced(&multi);
+                return coerced.AsArray(ErrorId, policy);
+            }
+
             MultiRowType nbRows(OperProps::getRows(lpxloper_));
             MultiColType nbCols(OperProps::getCols(lpxloper_));
 
@@ -827,10 +1001,29 @@ namespace xlw {
 
             MyArray result(ArrayTraits<MyArray>::create(nbRows * nbCols));
 
+            if(OperProps::isNumericMulti(lpxloper_))
+            {
+                // nothing to convert so read the values straight out
+                bool rowMajor(policy == XlfOperImpl::RowMajor || nbRows == 1 || nbCols == 1);
+                for(MultiRowType row(0); row < nbRows; ++row)
+                {
+                    for(MultiRowType col(0); col < nbCols; ++col)
+                    {
+                        size_t index(rowMajor ? (size_t)row * nbCols + col : (size_t)col * nbRows + row);
+                        ArrayTraits<MyArray>::setAt(result, index, OperProps::getNumericMultiValue(lpxloper_, row, col));
+                    }
+                }
+                return result;
+            }
+
+            // elements of references are allocated one at a time
+            // so release each once it has been converted
+            TempMemoryScope scratch;
             for(MultiRowType row(0); row < nbRows; ++row)
             {
                 for(MultiRowType col(0); col < nbCols; ++col)
                 {
+                    scratch.Rollback();
                     XlfOper element(OperProps::getElement(lpxloper_, row, col));
                     if(policy == XlfOperImpl::RowMajor)
                     {
@@ -847,13 +1040,37 @@ namespace xlw {
 
         MyMatrix AsMatrix(const char* ErrorId = 0) const
         {
+            OperType multi;
+            if(CoerceReferenceToMulti(multi))
+            {
+                blanksToZero(multi);
+                XlfOper coerced(&multi);
+                return coerced.AsMatrix(ErrorId);
+            }
+
             MultiRowType nbRows(OperProps::getRows(lpxloper_));
             MultiColType nbCols(OperProps::getCols(lpxloper_));
             MyMatrix result(MatrixTraits<MyMatrix>::create(nbRows, nbCols));
+            if(OperProps::isNumericMulti(lpxloper_))
+            {
+                // nothing to convert so read the values straight out
+                for(MultiRowType row(0); row < nbRows; ++row)
+                {
+                    for(MultiRowType col(0); col < nbCols; ++col)
+                    {
+                        MatrixTraits<MyMatrix>::setAt(result, row, col, OperProps::getNumericMultiValue(lpxloper_, row, col));
+                    }
+                }
+                return result;
+            }
+            // elements of references are allocated one at a time
+            // so release each once it has been converted
+            TempMemoryScope scratch;
             for(MultiRowType row(0); row < nbRows; ++row)
             {
                 for(MultiRowType col(0); col < nbCols; ++col)
                 {
+                    scratch.Rollback();
                     XlfOper element(OperProps::getElement(lpxloper_, row, col));
                     MatrixTraits<MyMatrix>::setAt(result, row, col, element.AsDouble(ErrorId));
                 }
@@ -863,6 +1080,13 @@ namespace xlw {
 
         CellMatrix AsCellMatrix(const char* ErrorId = 0) const
         {
+            OperType multi;
+            if(CoerceReferenceToMulti(multi))
+            {
+                XlfOper coerced(&multi);
+                return coerced.AsCellMatrix(ErrorId);
+            }
+
             if(IsMissing() || IsNil())
             {
                 CellMatrix result(1,1);
@@ -876,11 +1100,22 @@ namespace xlw {
             }
             MultiRowType nbRows(OperProps::getRows(lpxloper_));
             MultiColType nbCols(OperProps::getCols(lpxloper_));
+#ifdef USE_XLW_COLUMNAR_CELL_MATRIX
+            if(IsMulti())
+            {
+                // the columns are typed as they are read
+                return CellMatrix(new impl::ColumnarCellMatrix(OperProps::getElement(lpxloper_, 0, 0), nbRows, nbCols));
+            }
+#endif
             CellMatrix result(nbRows, nbCols);
+            // elements of references are allocated one at a time
+            // so release each once it has been converted
+            TempMemoryScope scratch;
             for(MultiRowType row(0); row < nbRows; ++row)
             {
                 for(MultiRowType col(0); col < nbCols; ++col)
                 {
+                    scratch.Rollback();
                     XlfOper element(OperProps::getElement(lpxloper_, row, col));
                     if(element.IsNumber())
                     {
@@ -935,6 +1170,11 @@ namespace xlw {
         {
             OperProps::setWString(lpxloper_, value);
         }
+        //! Set to a UTF-8 string.value
+        void Set(const Utf8String& value)
+        {
+            OperProps::setUtf8String(lpxloper_, value);
+        }
         //! Set to a double
         void Set(double value)
         {
@@ -1000,6 +1240,11 @@ namespace xlw {
         //! \name Equality operators
         //@{
         //! equals operator from same type
+        /*!
+        Also used for temporaries: an XlfOper may wrap an element of an
+        array in place, such as the one returned by operator(), so rhs
+        must be left alone and its value deep copied.
+        */
         XlfOper& operator=(const XlfOper& rhs)
         {
             OperProps::copy(rhs.lpxloper_, lpxloper_);
@@ -1055,6 +1300,13 @@ namespace xlw {
             return *this;
         }
 
+        //! equals operator from UTF-8 string
+        XlfOper& operator=(const Utf8String& rhs)
+        {
+            OperProps::setUtf8String(lpxloper_, rhs);
+            return *this;
+        }
+
         //! equals operator from c string
         XlfOper& operator=(const char* rhs)
         {
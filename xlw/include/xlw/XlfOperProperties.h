@@ -15,10 +15,17 @@
 
 #include <xlw/xlcall32.h>
 #include <xlw/PascalStringConversions.h>
+#include <xlw/ArrayPacker.h>
 #include <xlw/XlfExcel.h>
 #include <xlw/XlfRef.h>
 #include <xlw/XlfException.h>
 #include <string>
+#include <algorithm>
+
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#include <string_view>
+#define XLW_HAS_STRING_VIEW
+#endif
 
 
 #ifndef  XLFOPERPROPERTIES
@@ -120,7 +127,63 @@ namespace xlw {
             }
             THROW_XLW("No implementation on XlfOper rows");
         }
-        static void setArraySize(LPXLOPER12 oper, RW rows, COL cols)
+        //! True when oper is a multi made up only of numbers
+        static bool isNumericMulti(LPXLOPER12 oper)
+        {
+            if((oper->xltype & 0xFFF) != xltypeMulti)
+            {
+                return false;
+            }
+            const XLOPER12* element = oper->val.array.lparray;
+            const XLOPER12* end = element + (size_t)oper->val.array.rows * (size_t)oper->val.array.columns;
+            while(element != end)
+            {
+                // accumulate without branching within a block so the compiler
+                // can unroll the scan, checking between blocks to bail out early
+                const XLOPER12* blockEnd = element + std::min<size_t>(end - element, 64);
+                DWORD mismatch = 0;
+                for(; element != blockEnd; ++element)
+                {
+                    mismatch |= (element->xltype & 0xFFF) ^ xltypeNum;
+                }
+                if(mismatch)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+        //! Number at an element of a multi known to be numeric
+        static double getNumericMultiValue(LPXLOPER12 oper, size_t row, size_t column)
+        {
+            return oper->val.array.lparray[row * oper->val.array.columns + column].val.num;
+        }
+        //! Copies the values of a multi known to be numeric into out
+        static void copyNumericMulti(LPXLOPER12 oper, double* out, bool columnMajor)
+        {
+            const XLOPER12* values = oper->val.array.lparray;
+            size_t rows = oper->val.array.rows;
+            size_t cols = oper->val.array.columns;
+            if(!columnMajor || rows == 1 || cols == 1)
+            {
+                for(size_t item(0); item < rows * cols; ++item)
+                {
+                    out[item] = values[item].val.num;
+                }
+            }
+            else
+            {
+                for(size_t row(0); row < rows; ++row)
+                {
+                    for(size_t col(0); col < cols; ++col)
+                    {
+                        out[col * rows + row] = values[row * cols + col].val.num;
+                    }
+                }
+            }
+        }
+        //! Pass initialise as false only when every element will be set straight away
+        static void setArraySize(LPXLOPER12 oper, RW rows, COL cols, bool initialise = true)
         {
             if(rows > 0 && cols > 0)
             {
@@ -135,7 +198,18 @@ namespace xlw {
                     rows = 1048576;
                 }
 
-                oper->val.array.lparray = TempMemory::GetMemory<XLOPER12>((size_t)rows * (size_t)cols);
+                // arrays can be large enough to be served from a reused region,
+                // so rather than zeroing the whole block just give each element
+                // a type, writing a fraction of the bytes
+                size_t count((size_t)rows * (size_t)cols);
+                oper->val.array.lparray = TempMemory::GetMemoryUninitialized<XLOPER12>(count);
+                if(initialise)
+                {
+                    for(size_t i = 0; i < count; ++i)
+                    {
+                        oper->val.array.lparray[i].xltype = xltypeNil;
+                    }
+                }
                 oper->val.array.rows = rows;
                 oper->val.array.columns = cols;
                 oper->xltype = xltypeMulti;
@@ -220,6 +294,7 @@ namespace xlw {
                     result->val.mref.idSheet = oper->val.mref.idSheet;
                     result->val.mref.lpmref = TempMemory::GetMemory<XLMREF12>();
                     result->val.mref.lpmref->count = 1;
+                    result->val.mref.lpmref->reftbl[0] = oper->val.mref.lpmref->reftbl[0];
                     result->val.mref.lpmref->reftbl[0].rwFirst += row;
                     result->val.mref.lpmref->reftbl[0].rwLast = result->val.mref.lpmref->reftbl[0].rwFirst;
                     result->val.mref.lpmref->reftbl[0].colFirst += column;
@@ -262,6 +337,27 @@ namespace xlw {
             oper->val.str = PascalStringConversions::WStringToWPascalString(newValue);
             oper->xltype = xltypeStr;
         }
+#ifdef XLW_HAS_STRING_VIEW
+        static std::wstring_view getWStringView(LPXLOPER12 oper)
+        {
+            return std::wstring_view(oper->val.str + 1, oper->val.str[0]);
+        }
+        static std::string_view getStringView(LPXLOPER12 oper)
+        {
+            size_t length;
+            const char* narrowed = PascalStringConversions::WPascalStringToString(oper->val.str, length);
+            return std::string_view(narrowed, length);
+        }
+#endif
+        static std::string getUtf8String(LPXLOPER12 oper)
+        {
+            return PascalStringConversions::WPascalStringToUtf8(oper->val.str);
+        }
+        static void setUtf8String(LPXLOPER12 oper, const std::string& newValue)
+        {
+            oper->val.str = PascalStringConversions::Utf8ToWPascalString(newValue);
+            oper->xltype = xltypeStr;
+        }
         static XlfRef getRef(LPXLOPER12 oper)
         {
             const XLREF12& ref = oper->val.mref.lpmref->reftbl[0];
@@ -303,22 +399,43 @@ namespace xlw {
             switch(fromOper->xltype & 0xFFF)
             {
                 case xltypeMulti:
-                    // need to do a deep copy of each element
-                    toOper->xltype = xltypeMulti;
-                    toOper->val.array.lparray = TempMemory::GetMemory<XLOPER12>(fromOper->val.array.rows * fromOper->val.array.columns);
-                    for(size_t item(0) ; item < (size_t)(fromOper->val.array.rows * fromOper->val.array.columns); ++item)
                     {
-                        copy(fromOper->val.array.lparray + item, toOper->val.array.lparray + item);
+                        // need to do a deep copy of each element, with the
+                        // strings packed in after the elements
+                        size_t items((size_t)fromOper->val.array.rows * (size_t)fromOper->val.array.columns);
+                        XLOPER12* from(fromOper->val.array.lparray);
+                        size_t stringSpace(0);
+                        for(size_t item(0); item < items; ++item)
+                        {
+                            if((from[item].xltype & 0xFFF) == xltypeStr)
+                            {
+                                stringSpace += ArrayPacker::StringSpace(from[item].val.str);
+                            }
+                        }
+                        ArrayPacker packer(fromOper->val.array.rows, fromOper->val.array.columns);
+                        packer.Allocate(stringSpace);
+                        XLOPER12* to(packer.Elements());
+                        wchar_t* next(packer.Strings());
+                        for(size_t item(0); item < items; ++item)
+                        {
+                            if((from[item].xltype & 0xFFF) == xltypeStr)
+                            {
+                                ArrayPacker::SetString(to[item], from[item].val.str, next);
+                            }
+                            else
+                            {
+                                copy(from + item, to + item);
+                            }
+                        }
+                        packer.Finish(toOper);
                     }
-                    toOper->val.array.rows = fromOper->val.array.rows;
-                    toOper->val.array.columns = fromOper->val.array.columns;
                     break;
                 case xltypeRef:
                     {
                         toOper->xltype = xltypeRef;
                         toOper->val.mref.idSheet = fromOper->val.mref.idSheet;
                         size_t bytes(sizeof(XLMREF12) + (fromOper->val.mref.lpmref->count - 1) * sizeof(XLREF12));
-                        toOper->val.mref.lpmref = (XLMREF12*)TempMemory::GetMemory<BYTE>(bytes);
+                        toOper->val.mref.lpmref = (XLMREF12*)TempMemory::GetMemoryUninitialized<BYTE>(bytes);
                         memcpy(toOper->val.mref.lpmref, fromOper->val.mref.lpmref, bytes);
                     }
                     break;
@@ -60,9 +60,14 @@ namespace xlw
         // This is the copy constructor BUT does not do a deep copy
         // This is a shared pointer that is capable of deep copying
         // rather than a deep copy pointer
-        eshared_ptr( const eshared_ptr & r)
+        eshared_ptr( const eshared_ptr & r) noexcept
             :ptr_imp(r.ptr_imp),the_cloner(r.the_cloner){}
 
+        // Move constructor, takes over r without touching the reference counts.
+        // r is left without a cloner so can only be assigned to or destroyed
+        eshared_ptr( eshared_ptr && r) noexcept
+            :ptr_imp(std::move(r.ptr_imp)),the_cloner(std::move(r.the_cloner)){}
+
 
         // The standard Constructor that takes ownership of p
         // The p MUST have resulted from a new. eshared_ptr
@@ -107,6 +112,12 @@ namespace xlw
             return *this;
         }
 
+        eshared_ptr & operator=(eshared_ptr && r)
+        {
+            eshared_ptr(std::move(r)).swap(*this);
+            return *this;
+        }
+
         // Y* must be (statically) convertable to T* ( Y is derived from T )
         template<class Y> eshared_ptr & operator=(eshared_ptr<Y> const & r)
         {
@@ -153,6 +164,10 @@ namespace xlw
         // requested by the use
         eshared_ptr copy()const
         {
+            // Nothing to clone in a pointer that has been moved from
+            if(!the_cloner)
+                return *this;
+
             // Instantiate the copy
             eshared_ptr<T> the_copy;
 
@@ -220,7 +235,7 @@ namespace xlw
 
 
         /////////////////     SWAP that doesn't throw           //////
-        void swap(eshared_ptr & b)
+        void swap(eshared_ptr & b) noexcept
         {
             ptr_imp.swap(b.ptr_imp);
             the_cloner.swap(b.the_cloner);
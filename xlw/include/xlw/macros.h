@@ -29,6 +29,8 @@
 #include <xlw/XlfExcel.h>
 #include <xlw/CellMatrix.h>
 #include <xlw/TempMemory.h>
+#include <xlw/xlarray.h>
+#include <iostream>
 
 #if defined(_MSC_VER)
 #pragma once
@@ -146,6 +148,22 @@ return 1;
     return 0; \
 } \
 
+//! Cleanup macro for function whose result is written into the FP array argument array
+/*!
+Excel has no way of being told such a function failed and takes back
+whatever is in the argument, so on an exception the error is written to
+std::cerr and the whole array is filled with NaN rather than leaving it
+half written.
+*/
+#define EXCEL_END_INPLACE(array) \
+} catch (std::exception& error) { \
+    std::cerr << XLW__HERE__ << error.what() << std::endl; \
+    poisonFpArray(array); \
+} catch (...) { \
+    std::cerr << XLW__HERE__ << "unknown exception" << std::endl; \
+    poisonFpArray(array); \
+}
+
 //@}
 #endif
 
@@ -22,6 +22,8 @@
 #include "xlw/MyContainers.h"
 #include <xlw/xlfExcel.h>
 #include <xlw/TempMemory.h>
+#include <algorithm>
+#include <limits>
 
 namespace xlw {
 
@@ -63,11 +65,135 @@ namespace xlw {
 
     }
 
+    //! Read only view of the values of an FP12 array passed in from Excel
+    /*!
+    Excel passes FP12 arguments as a single block of doubles in row major
+    order so they can be used as they are with no copy. The span is only
+    valid for the duration of the call.
+    */
+    class ConstMatrixSpan
+    {
+    public:
+        ConstMatrixSpan(const FP12* input) :
+            data_(input->array), rows_(input->rows), columns_(input->columns)
+        {
+        }
+        ConstMatrixSpan(const double* data, size_t rows, size_t columns) :
+            data_(data), rows_(rows), columns_(columns)
+        {
+        }
+        size_t rows() const
+        {
+            return rows_;
+        }
+        size_t columns() const
+        {
+            return columns_;
+        }
+        size_t size() const
+        {
+            return rows_ * columns_;
+        }
+        //! The values in row major order
+        const double* data() const
+        {
+            return data_;
+        }
+        const double* row(size_t i) const
+        {
+            return data_ + i * columns_;
+        }
+        double operator()(size_t i, size_t j) const
+        {
+            return data_[i * columns_ + j];
+        }
+        const double* begin() const
+        {
+            return data_;
+        }
+        const double* end() const
+        {
+            return data_ + size();
+        }
+    private:
+        const double* data_;
+        size_t rows_;
+        size_t columns_;
+    };
+
+    //! Writable view of the values of an FP12 array
+    /*!
+    Used for arrays whose values are written in place, such as an
+    argument that Excel takes back as the result.
+    */
+    class MatrixSpan
+    {
+    public:
+        MatrixSpan(FP12* input) :
+            data_(input->array), rows_(input->rows), columns_(input->columns)
+        {
+        }
+        MatrixSpan(double* data, size_t rows, size_t columns) :
+            data_(data), rows_(rows), columns_(columns)
+        {
+        }
+        operator ConstMatrixSpan() const
+        {
+            return ConstMatrixSpan(data_, rows_, columns_);
+        }
+        size_t rows() const
+        {
+            return rows_;
+        }
+        size_t columns() const
+        {
+            return columns_;
+        }
+        size_t size() const
+        {
+            return rows_ * columns_;
+        }
+        //! The values in row major order
+        double* data() const
+        {
+            return data_;
+        }
+        double* row(size_t i) const
+        {
+            return data_ + i * columns_;
+        }
+        double& operator()(size_t i, size_t j) const
+        {
+            return data_[i * columns_ + j];
+        }
+        double* begin() const
+        {
+            return data_;
+        }
+        double* end() const
+        {
+            return data_ + size();
+        }
+    private:
+        double* data_;
+        size_t rows_;
+        size_t columns_;
+    };
+
+    //! Sets every value of array to a quiet NaN, so a half written result isn't taken for a real one
+    inline void poisonFpArray(FP12* array)
+    {
+        double* values = array->array;
+        double* end = values + (size_t)array->rows * (size_t)array->columns;
+        std::fill(values, end, std::numeric_limits<double>::quiet_NaN());
+    }
+
+    //! The values in the returned array are not initialised, every element must be set
     inline LPXLARRAY createTempFpArray(int rows, int cols, double*& arrayData)
     {
         LPXLARRAY result = 0;
 
-        result = (LPXLARRAY)TempMemory::GetMemory<BYTE>(sizeof(FP12) + (rows * cols - 1) * sizeof(double));
+        result = (LPXLARRAY)TempMemory::GetMemoryUninitialized<BYTE>(sizeof(FP12) + (rows * cols - 1) * sizeof(double));
         result->rows = rows;
         result->columns = cols;
         arrayData = result->array;
@@ -32,6 +32,7 @@
 #include <xlw/XlfCmdDesc.h>
 #include <xlw/XlfFuncDesc.h>
 #include <xlw/XlfOper.h>
+#include <xlw/OperView.h>
 #include <xlw/XlfRef.h>
 #include <xlw/CellMatrix.h>
 #include <xlw/XlFunctionRegistration.h>
@@ -20,79 +20,464 @@
 #include <sstream>
 #include <xlw/PascalStringConversions.h>
 #include <algorithm>
+#include <xlw/XlfException.h>
+#include <xlw/XlfOper.h>
+#include <xlw/ArgumentListCache.h>
 
 namespace
 {
-    xlw::CellMatrix ExtractCells(xlw::CellMatrix& cells,
-                            size_t row,
-                            size_t column,
-                            std::string ErrorId,
-                            std::string thisName,
-                            bool& nonNumeric)
+    // a block of a CellMatrix read in place
+    class CellMatrixBlock
     {
-        if (!cells(row,column).IsANumber())
+    public:
+        typedef xlw::CellValue Cell;
+
+        explicit CellMatrixBlock(const xlw::CellMatrix& cells)
+            : cells_(cells), row_(0), column_(0),
+              rows_(cells.RowsInStructure()), columns_(cells.ColumnsInStructure())
+        {
+        }
+        size_t RowsInStructure() const
+        {
+            return rows_;
+        }
+        size_t ColumnsInStructure() const
+        {
+            return columns_;
+        }
+        const xlw::CellValue& operator()(size_t row, size_t column) const
+        {
+            return cells_(row_ + row, column_ + column);
+        }
+        CellMatrixBlock Block(size_t row, size_t column, size_t rows, size_t columns) const
+        {
+            return CellMatrixBlock(cells_, row_ + row, column_ + column, rows, columns);
+        }
+
+    private:
+        CellMatrixBlock(const xlw::CellMatrix& cells, size_t row, size_t column, size_t rows, size_t columns)
+            : cells_(cells), row_(row), column_(column), rows_(rows), columns_(columns)
+        {
+        }
+
+        const xlw::CellMatrix& cells_;
+        size_t row_;
+        size_t column_;
+        size_t rows_;
+        size_t columns_;
+    };
+
+    // a block of the elements of an xltypeMulti read in place
+    class OperBlock
+    {
+    public:
+        typedef XLOPER12 Cell;
+
+        OperBlock(const XLOPER12* elements, size_t rows, size_t columns)
+            : elements_(elements), stride_(columns), rows_(rows), columns_(columns)
+        {
+        }
+        size_t RowsInStructure() const
+        {
+            return rows_;
+        }
+        size_t ColumnsInStructure() const
+        {
+            return columns_;
+        }
+        const XLOPER12& operator()(size_t row, size_t column) const
+        {
+            return elements_[row * stride_ + column];
+        }
+        OperBlock Block(size_t row, size_t column, size_t rows, size_t columns) const
+        {
+            OperBlock block(elements_ + row * stride_ + column, rows, columns);
+            block.stride_ = stride_;
+            return block;
+        }
+
+    private:
+        const XLOPER12* elements_;
+        size_t stride_;
+        size_t rows_;
+        size_t columns_;
+    };
+
+    bool IsEmpty(const xlw::CellValue& cell)
+    {
+        return cell.IsEmpty();
+    }
+    bool IsString(const xlw::CellValue& cell)
+    {
+        return cell.IsAString() || cell.IsAWstring();
+    }
+    bool IsNumber(const xlw::CellValue& cell)
+    {
+        return cell.IsANumber();
+    }
+    bool IsBoolean(const xlw::CellValue& cell)
+    {
+        return cell.IsBoolean();
+    }
+    bool IsError(const xlw::CellValue& cell)
+    {
+        return cell.IsError();
+    }
+    std::string StringValue(const xlw::CellValue& cell)
+    {
+        return cell.StringValue();
+    }
+    double NumericValue(const xlw::CellValue& cell)
+    {
+        return cell.NumericValue();
+    }
+    bool BooleanValue(const xlw::CellValue& cell)
+    {
+        return cell.BooleanValue();
+    }
+    void CopyCell(const xlw::CellValue& from, xlw::CellValue& to)
+    {
+        to = from;
+    }
+
+    // the same conversions as XlfOper::AsCellMatrix
+    bool IsEmpty(const XLOPER12& cell)
+    {
+        return (cell.xltype & (xltypeNil | xltypeMissing)) != 0;
+    }
+    bool IsString(const XLOPER12& cell)
+    {
+        return (cell.xltype & xltypeStr) != 0;
+    }
+    bool IsNumber(const XLOPER12& cell)
+    {
+        return (cell.xltype & (xltypeNum | xltypeInt)) != 0;
+    }
+    bool IsBoolean(const XLOPER12& cell)
+    {
+        return (cell.xltype & xltypeBool) != 0;
+    }
+    bool IsError(const XLOPER12& cell)
+    {
+        return (cell.xltype & xltypeErr) != 0;
+    }
+    std::string StringValue(const XLOPER12& cell)
+    {
+        if (!IsString(cell))
+            THROW_XLW("non string cell asked to be a string");
+
+        // narrowed a character at a time as CellValue::StringValue does
+        const wchar_t* text = cell.val.str;
+        return std::string(text + 1, text + 1 + static_cast<size_t>(text[0]));
+    }
+    double NumericValue(const XLOPER12& cell)
+    {
+        return (cell.xltype & xltypeInt) ? static_cast<double>(cell.val.w) : cell.val.num;
+    }
+    bool BooleanValue(const XLOPER12& cell)
+    {
+        return cell.val.xbool != 0;
+    }
+    void CopyCell(const XLOPER12& from, xlw::CellValue& to)
+    {
+        if (IsNumber(from))
+            to = NumericValue(from);
+        else if (IsString(from))
+            to = std::wstring(from.val.str + 1, from.val.str + 1 + static_cast<size_t>(from.val.str[0]));
+        else if (IsBoolean(from))
+            to = BooleanValue(from);
+        else if (IsError(from))
+            to = xlw::CellValue::error_type(from.val.err);
+        else if (!IsEmpty(from))
+            THROW_XLW("Unsupported type in CellMatrix conversion");
+    }
+
+    // which cells of a block have been read
+    class ConsumedCells
+    {
+    public:
+        ConsumedCells(size_t rows, size_t columns) : columns_(columns), consumed_(rows * columns, false)
+        {
+        }
+        bool operator()(size_t row, size_t column) const
+        {
+            return consumed_[row * columns_ + column];
+        }
+        void Consume(size_t row, size_t column)
+        {
+            consumed_[row * columns_ + column] = true;
+        }
+
+    private:
+        size_t columns_;
+        std::vector<bool> consumed_;
+    };
+
+    void NarrowStrings(const xlw::CellMatrix& cells)
+    {
+        for (size_t i=0; i < cells.RowsInStructure(); i++)
+            for (size_t j=0; j < cells.ColumnsInStructure(); j++)
+                if (cells(i,j).IsAWstring())
+                    cells(i,j).StringValue();
+    }
+
+    template<class BLOCK>
+    bool IsUnread(const BLOCK& cells, const ConsumedCells& consumed, size_t row, size_t column)
+    {
+        return !consumed(row, column) && !IsEmpty(cells(row, column));
+    }
+
+    // filled through the implementation rather than the matrix's non const
+    // operator(), which would stop the cells being shared by later copies
+    template<class BLOCK>
+    xlw::CellMatrix Materialize(const BLOCK& cells, bool& nonNumeric)
+    {
+        xlw::CellMatrixImpl* impl = new xlw::CellMatrixImpl(cells.RowsInStructure(), cells.ColumnsInStructure());
+        xlw::CellMatrix result(impl);
+        for (size_t i=0; i < cells.RowsInStructure(); i++)
+            for (size_t j=0; j < cells.ColumnsInStructure(); j++)
+            {
+                CopyCell(cells(i,j), (*impl)(i,j));
+
+                if (!IsNumber(cells(i,j)))
+                    nonNumeric = true;
+            }
+
+        return result;
+    }
+
+    template<class BLOCK>
+    BLOCK ExtractCells(const BLOCK& cells,
+                       ConsumedCells& consumed,
+                       size_t row,
+                       size_t column,
+                       const std::string& ErrorId,
+                       const std::string& thisName)
+    {
+        if (row >= cells.RowsInStructure())
+            THROW_XLW(ErrorId << " " << thisName << " rows and columns expected.");
+        if (!IsNumber(cells(row,column)))
             THROW_XLW(ErrorId << " " << thisName << " rows and columns expected.");
         if (cells.ColumnsInStructure() <= column+1)
             THROW_XLW(ErrorId << " " << thisName << " rows and columns expected.");
-        if (!cells(row,column+1).IsANumber())
+        if (!IsNumber(cells(row,column+1)))
             THROW_XLW(ErrorId << " " << thisName << " rows and columns expected.");
 
-        unsigned long numberRows_UL = cells(row,column);
-        unsigned long numberColumns_UL = cells(row,column+1);
+        size_t numberRows = static_cast<size_t>(static_cast<unsigned long>(NumericValue(cells(row,column))));
+        size_t numberColumns = static_cast<size_t>(static_cast<unsigned long>(NumericValue(cells(row,column+1))));
 
-        size_t numberRows = static_cast<size_t>(numberRows_UL);
-        size_t numberColumns = static_cast<size_t>(numberColumns_UL);
-
-        cells(row,column).clear();
-        cells(row,column+1).clear();
-
-        xlw::CellMatrix result(numberRows,numberColumns);
+        consumed.Consume(row,column);
+        consumed.Consume(row,column+1);
 
         if (numberRows +row+1>cells.RowsInStructure())
-            throw(ErrorId+" "+thisName+" insufficient rows in structure");
+            THROW_XLW(ErrorId << " " << thisName << " insufficient rows in structure");
 
         if (numberColumns +column>cells.ColumnsInStructure())
-            throw(ErrorId+" "+thisName+" insufficient columns in structure");
+            THROW_XLW(ErrorId << " " << thisName << " insufficient columns in structure");
 
         for (size_t i=0; i < numberRows; i++)
             for (size_t j=0; j < numberColumns; j++)
-            {
-                result(i,j) = cells(row+1+i,column+j);
-                cells(row+1+i,column+j).clear();
+                consumed.Consume(row+1+i,column+j);
 
-                if (!result(i,j).IsANumber())
-                    nonNumeric = true;
+        return cells.Block(row+1, column, numberRows, numberColumns);
+    }
+
+    const size_t MinimumTableSize = 16;
+
+    inline char FoldCase(char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    size_t HashFolded(const std::string& name)
+    {
+        // FNV-1a
+        size_t hash = sizeof(size_t) == 8 ? size_t(14695981039346656037ULL) : size_t(2166136261U);
+        const size_t prime = sizeof(size_t) == 8 ? size_t(1099511628211ULL) : size_t(16777619U);
+        for (size_t i = 0; i < name.size(); ++i)
+        {
+            hash ^= static_cast<unsigned char>(FoldCase(name[i]));
+            hash *= prime;
+        }
+        return hash;
+    }
+
+    bool EqualsFolded(const std::string& name, const std::string& key)
+    {
+        if (name.size() != key.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < name.size(); ++i)
+        {
+            if (FoldCase(name[i]) != key[i])
+            {
+                return false;
             }
+        }
+        return true;
+    }
 
-        return result;
+    // the order AllData has always written the types in
+    int AllDataRank(xlw::ArgumentList::ArgumentType type)
+    {
+        switch (type)
+        {
+        case xlw::ArgumentList::number: return 0;
+        case xlw::ArgumentList::vector: return 1;
+        case xlw::ArgumentList::matrix: return 2;
+        case xlw::ArgumentList::string: return 3;
+        case xlw::ArgumentList::boolean: return 4;
+        case xlw::ArgumentList::cells: return 5;
+        default: return 6;
+        }
     }
 
+    class AllDataOrder
+    {
+    public:
+        explicit AllDataOrder(const std::vector<std::pair<std::string, xlw::ArgumentList::ArgumentType> >& names)
+            : names_(names)
+        {
+        }
+        bool operator()(size_t lhs, size_t rhs) const
+        {
+            int lhsRank = AllDataRank(names_[lhs].second);
+            int rhsRank = AllDataRank(names_[rhs].second);
+            return lhsRank != rhsRank ? lhsRank < rhsRank : names_[lhs].first < names_[rhs].first;
+        }
+    private:
+        const std::vector<std::pair<std::string, xlw::ArgumentList::ArgumentType> >& names_;
+    };
+}
 
+const size_t xlw::ArgumentNameIndex::npos;
+
+xlw::ArgumentNameIndex::ArgumentNameIndex()
+{
+}
+
+void xlw::ArgumentNameIndex::FoldCase(std::string& name)
+{
+    for (size_t i = 0; i < name.size(); ++i)
+    {
+        name[i] = ::FoldCase(name[i]);
+    }
+}
+
+size_t xlw::ArgumentNameIndex::Find(const std::string& name) const
+{
+    return Table.empty() ? npos : Find(name, HashFolded(name));
+}
+
+size_t xlw::ArgumentNameIndex::Find(const std::string& name, size_t hash) const
+{
+    size_t mask = Table.size() - 1;
+    for (size_t i = hash & mask; Table[i] != 0; i = (i + 1) & mask)
+    {
+        size_t position = Table[i] - 1;
+        if (Hashes[position] == hash && EqualsFolded(name, Keys[position]))
+        {
+            return position;
+        }
+    }
+    return npos;
+}
+
+size_t xlw::ArgumentNameIndex::Insert(const std::string& name)
+{
+    size_t hash = HashFolded(name);
+    if (!Table.empty() && Find(name, hash) != npos)
+    {
+        return npos;
+    }
+
+    // keep the table at most half full
+    if (2 * (Keys.size() + 1) > Table.size())
+    {
+        Rehash(std::max(MinimumTableSize, 2 * Table.size()));
+    }
+
+    size_t position = Keys.size();
+    Keys.push_back(name);
+    FoldCase(Keys.back());
+    Hashes.push_back(hash);
+
+    size_t mask = Table.size() - 1;
+    size_t i = hash & mask;
+    while (Table[i] != 0)
+    {
+        i = (i + 1) & mask;
+    }
+    Table[i] = static_cast<unsigned int>(position + 1);
+    return position;
+}
+
+void xlw::ArgumentNameIndex::Rehash(size_t capacity)
+{
+    Table.assign(capacity, 0);
+    size_t mask = capacity - 1;
+    for (size_t position = 0; position < Keys.size(); ++position)
+    {
+        size_t i = Hashes[position] & mask;
+        while (Table[i] != 0)
+        {
+            i = (i + 1) & mask;
+        }
+        Table[i] = static_cast<unsigned int>(position + 1);
+    }
+}
+
+xlw::ArgumentSlot xlw::ArgumentSchema::Add(const std::string& ArgumentName)
+{
+    size_t index = Names.Insert(ArgumentName);
+    ArgumentSlot slot = { this, index == ArgumentNameIndex::npos ? Names.Find(ArgumentName) : index };
+    return slot;
+}
+
+xlw::ArgumentSlot xlw::ArgumentSchema::Slot(const std::string& ArgumentName) const
+{
+    size_t index = Names.Find(ArgumentName);
+    if (index == ArgumentNameIndex::npos)
+        THROW_XLW("Argument name not in schema: " << ArgumentName);
+
+    ArgumentSlot slot = { this, index };
+    return slot;
 }
 
 namespace xlw
 {
     template<class TYPE>
-    void ArgumentList::addInternal(const std::string& ArgumentName, const TYPE& value, std::map<std::string,TYPE>& typeMap, ArgumentType type)
+    void ArgumentList::addInternal(const std::string& ArgumentName, const TYPE& value, std::vector<TYPE> Values::* values, ArgumentType type)
     {
-        std::pair<std::string, TYPE> valuePair(ArgumentName,value);
-        typeMap.insert(valuePair);
-
         RegisterName(ArgumentName, type);
+
+        std::vector<TYPE>& typeValues = (*Data).*values;
+        Data->ValuePositions.push_back(typeValues.size());
+        typeValues.push_back(value);
     }
 
     template<class TYPE>
-    const TYPE& ArgumentList::GetArgumentValueInternal(std::string ArgumentName, std::map<std::string, TYPE>& typeMap)
+    void ArgumentList::addInternal(const std::string& ArgumentName, TYPE&& value, std::vector<TYPE> Values::* values, ArgumentType type)
     {
-        StringUtilities::makeLower(ArgumentName);
-        typename std::map<std::string, TYPE>::const_iterator it = typeMap.find(ArgumentName);
+        RegisterName(ArgumentName, type);
+
+        std::vector<TYPE>& typeValues = (*Data).*values;
+        Data->ValuePositions.push_back(typeValues.size());
+        typeValues.push_back(std::move(value));
+    }
 
-        if (it == typeMap.end())
-            THROW_XLW(StructureName << " unknown string argument asked for :" << ArgumentName);
+    template<class KEY>
+    size_t ArgumentList::UseArgument(const KEY& key, ArgumentType type)
+    {
+        size_t position = Find(key);
+
+        if (position == ArgumentNameIndex::npos || Data->ArgumentNames[position].second != type)
+            THROW_XLW(Data->StructureName << " unknown string argument asked for :" << NameOf(key));
 
-        UseArgumentName(ArgumentName);
+        Used[position] = true;
 
-        return it->second;
+        return Data->ValuePositions[position];
     }
 }
 
@@ -103,422 +488,585 @@ void xlw::ArgumentList::add(const std::string& ArgumentName, const char * value)
 
 void xlw::ArgumentList::add(const std::string& ArgumentName, const std::string& value)
 {
-    addInternal(ArgumentName, value, StringArguments, string);
+    addInternal(ArgumentName, value, &Values::StringArguments, string);
 }
 
 void xlw::ArgumentList::add(const std::string& ArgumentName, double value)
 {
-    addInternal(ArgumentName, value, DoubleArguments, number);
+    addInternal(ArgumentName, value, &Values::DoubleArguments, number);
 }
 
 void xlw::ArgumentList::add(const std::string& ArgumentName, bool value)
 {
-    addInternal(ArgumentName, value, BoolArguments, boolean);
+    addInternal(ArgumentName, value, &Values::BoolArguments, boolean);
 }
 
 void xlw::ArgumentList::add(const std::string& ArgumentName, const CellMatrix& values)
 {
-    addInternal(ArgumentName, values, CellArguments, cells);
+    addInternal(ArgumentName, values, &Values::CellArguments, cells);
 }
 
 void xlw::ArgumentList::addList(const std::string& ArgumentName, const CellMatrix& values)
 {
-    addInternal(ArgumentName, values, ListArguments, list);
+    addInternal(ArgumentName, values, &Values::CellArguments, list);
 }
 
 void xlw::ArgumentList::addArray(const std::string& ArgumentName, const CellMatrix& values)
 {
-    addInternal(ArgumentName, values, ArrayArguments, vector);
+    addInternal(ArgumentName, values, &Values::CellArguments, vector);
 }
 
 void xlw::ArgumentList::addMatrix(const std::string& ArgumentName, const CellMatrix& values)
 {
-    addInternal(ArgumentName, values, MatrixArguments, matrix);
+    addInternal(ArgumentName, values, &Values::CellArguments, matrix);
 }
 
 void xlw::ArgumentList::add(const std::string& ArgumentName, const ArgumentList& values)
 {
     CellMatrix cellValues(values.AllData());
-    addInternal(ArgumentName, cellValues, ListArguments, list);
+    addInternal(ArgumentName, cellValues, &Values::CellArguments, list);
 }
 
-xlw::ArgumentList::ArgumentList(CellMatrix cells, std::string ErrorId)
+namespace xlw
 {
+    template<class BLOCK>
+    void ArgumentList::Parse(const BLOCK& cells, std::string ErrorId)
+    {
+        typedef typename BLOCK::Cell Cell;
 
-    size_t rows = cells.RowsInStructure();
-    size_t columns = cells.ColumnsInStructure();
+        size_t rows = cells.RowsInStructure();
+        size_t columns = cells.ColumnsInStructure();
 
-    if (rows == 0)
-        THROW_XLW("Argument List requires non empty cell matix " << ErrorId);
+        if (rows == 0)
+            THROW_XLW("Argument List requires non empty cell matix " << ErrorId);
 
-    //if (!cells(0,0).IsAString())
-    if (!cells(0,0).IsAString() && !cells(0,0).IsAWstring())//FIXME
-        THROW_XLW("a structure name must be specified for argument list class " << ErrorId);
-    else
-    {
-        StructureName = StringUtilities::toLower(cells(0,0).StringValue());
-		cells(0,0).clear();
-    }
+        if (!IsString(cells(0,0)))
+            THROW_XLW("a structure name must be specified for argument list class " << ErrorId);
+        else
+        {
+            Data->StructureName = StringValue(cells(0,0));
+            ArgumentNameIndex::FoldCase(Data->StructureName);
+        }
 
 
-    {for (size_t i=1; i < columns; i++)
-        if (!cells(0,i).IsEmpty() )
-            THROW_XLW("An argument list should only have the structure name on the first line: " << StructureName+ " " << ErrorId);
-    }
+        {for (size_t i=1; i < columns; i++)
+            if (!IsEmpty(cells(0,i)) )
+                THROW_XLW("An argument list should only have the structure name on the first line: " << Data->StructureName+ " " << ErrorId);
+        }
 
-    ErrorId +=" "+StructureName;
+        ErrorId +=" "+Data->StructureName;
 
-    {for (size_t i=1; i < rows; i++)
-        for (size_t j=0; j < columns; j++)
-            if (cells(i,j).IsError())
-                GenerateThrow("Error Cell passed in ",i,j);}
+        {for (size_t i=1; i < rows; i++)
+            for (size_t j=0; j < columns; j++)
+                if (IsError(cells(i,j)))
+                    GenerateThrow("Error Cell passed in ",i,j);}
 
-    size_t row=1UL;
+        // cells are marked as they are read rather than cleared,
+        // so the block needn't be copied
+        ConsumedCells consumed(rows, columns);
+        consumed.Consume(0,0);
 
-    while (row < rows)
-    {
-        size_t rowsDown=1;
-        size_t column = 0;
+        size_t row=1UL;
 
-        while (column < columns)
+        while (row < rows)
         {
-            if (cells(row,column).IsEmpty())
+            size_t rowsDown=1;
+            size_t column = 0;
+
+            while (column < columns)
             {
-                // check nothing else in row
-                while (column< columns)
+                if (!IsUnread(cells, consumed, row, column))
                 {
-                    if (!cells(row,column).IsEmpty())
-                        GenerateThrow("data or value where unexpected.",row, column);
+                    // check nothing else in row
+                    while (column< columns)
+                    {
+                        if (IsUnread(cells, consumed, row, column))
+                            GenerateThrow("data or value where unexpected.",row, column);
 
-                    ++column;
+                        ++column;
+                    }
                 }
-            }
-            else // we have data
-            {
-                //if (!cells(row,column).IsAString())
-                if (!cells(row,column).IsAString() && !cells(row,column).IsAWstring())//FIXME
-                    GenerateThrow("data  where name expected.", row, column);
-
-                std::string thisName(StringUtilities::toLower(cells(row,column).StringValue()));
+                else // we have data
+                {
+                    if (!IsString(cells(row,column)))
+                        GenerateThrow("data  where name expected.", row, column);
 
-                if (thisName =="")
-                    GenerateThrow("empty name not permissible.", row, column);
+                    std::string thisName(StringValue(cells(row,column)));
+                    ArgumentNameIndex::FoldCase(thisName);
 
-                if (rows == row+1)
-                    GenerateThrow("No space where data expected below name", row, column);
+                    if (thisName =="")
+                        GenerateThrow("empty name not permissible.", row, column);
 
-                cells(row,column).clear();
-                // weird syntax to satisfy VC6
-                //CellValue* belowPtr = &cells(row+1,column);
-                //CellValue& cellBelow = *belowPtr;
-                CellValue& cellBelow = cells(row+1,column);
+                    if (rows == row+1)
+                        GenerateThrow("No space where data expected below name", row, column);
 
-                if (cellBelow.IsEmpty())
-                    GenerateThrow("Data expected below name", row, column);
+                    consumed.Consume(row,column);
 
-                if (cellBelow.IsANumber())
-                {
-                    add(thisName, cellBelow.NumericValue());
+                    if (!IsUnread(cells, consumed, row+1, column))
+                        GenerateThrow("Data expected below name", row, column);
 
-                    column++;
+                    const Cell& cellBelow = cells(row+1,column);
+                    consumed.Consume(row+1,column);
 
-					cellBelow.clear();
-                }
-                else
-                    if (cellBelow.IsBoolean())
+                    if (IsNumber(cellBelow))
                     {
-                        add(thisName, cellBelow.BooleanValue());
+                        add(thisName, NumericValue(cellBelow));
 
                         column++;
-
-						cellBelow.clear();
                     }
-                    else // ok it's a string
-                    {
-                        std::string stringVal = StringUtilities::toLower(cellBelow.StringValue());
-
-                        if ( (stringVal == "list") ||
-                            (stringVal == "matrix") ||
-                            (stringVal == "cells") )
+                    else
+                        if (IsBoolean(cellBelow))
                         {
-                            bool nonNumeric = false;
-                            CellMatrix extracted(ExtractCells(cells,row+2,column,ErrorId,thisName,nonNumeric));
+                            add(thisName, BooleanValue(cellBelow));
 
+                            column++;
+                        }
+                        else // ok it's a string
+                        {
+                            std::string stringVal = StringValue(cellBelow);
+                            ArgumentNameIndex::FoldCase(stringVal);
 
-                            if (stringVal == "list")
+                            if ( (stringVal == "list") ||
+                                (stringVal == "matrix") ||
+                                (stringVal == "cells") )
                             {
-                                ArgumentList value(extracted,ErrorId+":"+thisName);
+                                BLOCK extracted(ExtractCells(cells,consumed,row+2,column,ErrorId,thisName));
 
-                                addList(thisName, extracted); //note not value
+                                if (stringVal == "list")
+                                {
+                                    // checked in place, only the cells are kept
+                                    ArgumentList value(thisName);
+                                    value.Parse(extracted,ErrorId+":"+thisName);
+                                }
 
-                            }
+                                bool nonNumeric = false;
+                                CellMatrix values(Materialize(extracted,nonNumeric));
 
-                            if (stringVal == "cells")
-                            {
-                                add(thisName,extracted);
-                            }
+                                if (stringVal == "list")
+                                {
+                                    addInternal(thisName, std::move(values), &Values::CellArguments, list);
+                                }
 
+                                if (stringVal == "cells")
+                                {
+                                    addInternal(thisName, std::move(values), &Values::CellArguments, ArgumentList::cells);
+                                }
 
-                            if (stringVal == "matrix")
-                            {
-                                if (nonNumeric)
-                                    THROW_XLW("Non numerical value in matrix argument :" << thisName <<  " " << ErrorId);
 
-                                addInternal(thisName, extracted, MatrixArguments, matrix);
-                            }
+                                if (stringVal == "matrix")
+                                {
+                                    if (nonNumeric)
+                                        THROW_XLW("Non numerical value in matrix argument :" << thisName <<  " " << ErrorId);
 
-                            cellBelow.clear();
-                            rowsDown = std::max(rowsDown,extracted.RowsInStructure()+2);
-                            column+= extracted.ColumnsInStructure();
-                        }
-                        else // ok it's an array or boring string
-                        {
-                            if (stringVal == "array"
-                                ||stringVal == "vector" )
+                                    addInternal(thisName, std::move(values), &Values::CellArguments, matrix);
+                                }
+
+                                rowsDown = std::max(rowsDown,extracted.RowsInStructure()+2);
+                                column+= extracted.ColumnsInStructure();
+                            }
+                            else // ok it's an array or boring string
                             {
-                                cellBelow.clear();
+                                if (stringVal == "array"
+                                    ||stringVal == "vector" )
+                                {
+                                    if (row+2>= rows)
+                                        THROW_XLW(ErrorId << " data expected below array " << thisName);
 
-                                if (row+2>= rows)
-                                    THROW_XLW(ErrorId << " data expected below array " << thisName);
+                                    if (!IsNumber(cells(row+2,column)))
+                                        THROW_XLW(ErrorId << " size expected below array " << thisName);
 
-                                size_t size = static_cast<size_t>((unsigned long)cells(row+2,column));
-                                cells(row+2,column).clear();
+                                    size_t size = static_cast<size_t>(static_cast<unsigned long>(NumericValue(cells(row+2,column))));
+                                    consumed.Consume(row+2,column);
 
-                                if (row+2+size>=rows)
-                                    THROW_XLW(ErrorId << " more data expected below array " << thisName);
+                                    if (row+2+size>=rows)
+                                        THROW_XLW(ErrorId << " more data expected below array " << thisName);
 
-                                CellMatrix theArray(size, 1);
+                                    CellMatrixImpl* arrayImpl = new CellMatrixImpl(size, 1);
+                                    CellMatrix theArray(arrayImpl);
 
-                                for (size_t i=0; i < size; i++)
-                                {
-                                    CellValue& theValue(cells(row+3+i,column));
-                                    if(theValue.IsANumber())
-                                    {
-                                        theArray(i, 0) = theValue;
-                                        theValue.clear();
-                                    }
-                                    else
+                                    for (size_t i=0; i < size; i++)
                                     {
-                                        THROW_XLW("Non numerical value in array argument :" << thisName+ " " << ErrorId);
+                                        const Cell& theValue(cells(row+3+i,column));
+                                        if(IsNumber(theValue))
+                                        {
+                                            (*arrayImpl)(i, 0) = NumericValue(theValue);
+                                            consumed.Consume(row+3+i,column);
+                                        }
+                                        else
+                                        {
+                                            THROW_XLW("Non numerical value in array argument :" << thisName+ " " << ErrorId);
+                                        }
                                     }
-                                }
 
-                                addInternal(thisName, theArray, ArrayArguments, vector);
+                                    addInternal(thisName, std::move(theArray), &Values::CellArguments, vector);
 
-                                rowsDown = std::max(rowsDown,size+2);
+                                    rowsDown = std::max(rowsDown,size+2);
 
-                                column+=1;
+                                    column+=1;
+                                }
+                                else
+                                {
+                                    add(thisName,stringVal);
+                                    column++;
+                                }
                             }
-                            else
-                            {
-                                std::string value = stringVal;
-                                add(thisName,value);
-                                column++;
 
-								cellBelow.clear();
-                            }
                         }
+                }
 
-                    }
             }
+            row+=rowsDown+1;
 
         }
-        row+=rowsDown+1;
 
+        {for (size_t i=0; i < rows; i++)
+            for (size_t j=0; j < columns; j++)
+                if (IsUnread(cells, consumed, i, j))
+                {
+                   GenerateThrow("extraneous data "+ErrorId,i,j);
+        }}
     }
+}
 
-    {for (size_t i=0; i < rows; i++)
-        for (size_t j=0; j < columns; j++)
-            if (!cells(i,j).IsEmpty())
-            {
-               GenerateThrow("extraneous data "+ErrorId,i,j);
-    }}
+xlw::ArgumentList::ArgumentList(CellMatrix cells, std::string ErrorId) : Data(new Values)
+{
+    Parse(CellMatrixBlock(cells), ErrorId);
+}
+
+xlw::ArgumentList::ArgumentList(const XlfOper& cells, std::string ErrorId) : Data(new Values)
+{
+    XLOPER12 multi;
+    if (cells.CoerceReferenceToMulti(multi))
+    {
+        XlfOper coerced(&multi);
+        ParseElements(multi.val.array.lparray, multi.val.array.rows, multi.val.array.columns, ErrorId);
+    }
+    else if (cells.IsRef() || cells.IsSRef())
+    {
+        CellMatrix converted(cells.AsCellMatrix(ErrorId.c_str()));
+        Parse(CellMatrixBlock(converted), ErrorId);
+    }
+    else
+    {
+        const XLOPER12* oper = cells;
+        if (cells.IsMulti())
+            ParseElements(oper->val.array.lparray, oper->val.array.rows, oper->val.array.columns, ErrorId);
+        else
+            ParseElements(oper, 1, 1, ErrorId);
+    }
+}
+
+void xlw::ArgumentList::ParseElements(const XLOPER12* cells, size_t rows, size_t columns, const std::string& ErrorId)
+{
+    if (ArgumentListCache::Capacity() == 0)
+    {
+        Parse(OperBlock(cells, rows, columns), ErrorId);
+        return;
+    }
+
+    std::string key;
+    ArgumentListCache::MakeKey(cells, rows, columns, key);
+    if (ArgumentListCache::Find(key, *this))
+        return;
+
+    Parse(OperBlock(cells, rows, columns), ErrorId);
+
+    // other threads will read the cells of the cached list,
+    // so make the strings they might ask for now
+    for (size_t k = 0; k < Data->CellArguments.size(); ++k)
+        NarrowStrings(Data->CellArguments[k]);
+
+    ArgumentListCache::Insert(key, *this);
 }
 
 void xlw::ArgumentList::RegisterName(const std::string& ArgumentName, ArgumentType type)
 {
-    ArgumentNames.push_back(std::make_pair(ArgumentName,type));
-    if (!(Names.insert(*ArgumentNames.rbegin()).second) )
+    Unshare();
+
+    size_t position = Data->Names.Insert(ArgumentName);
+    if (position == ArgumentNameIndex::npos)
                 THROW_XLW("Same argument name used twice " << ArgumentName);
 
-    ArgumentsUsed.insert(std::pair<std::string,bool>(ArgumentName,false));
+    Data->ArgumentNames.push_back(std::make_pair(ArgumentName,type));
+    Used.push_back(false);
+
+    // the values are not shared now so nothing else can be reading these
+    Data->ClearBindings();
+}
 
+void xlw::ArgumentList::Unshare()
+{
+    if (Data.use_count() > 1)
+        Data = Data.copy();
 }
 
 std::string xlw::ArgumentList::GetStructureName() const
 {
-    return StructureName;
+    return Data->StructureName;
 }
 
 const std::vector<std::pair<std::string, xlw::ArgumentList::ArgumentType> >& xlw::ArgumentList::GetArgumentNamesAndTypes() const
 {
-    return ArgumentNames;
+    return Data->ArgumentNames;
+}
+
+size_t xlw::ArgumentList::Find(const std::string& ArgumentName) const
+{
+    return Data->Names.Find(ArgumentName);
+}
+
+size_t xlw::ArgumentList::Find(ArgumentSlot Argument) const
+{
+    for (const Binding* binding = Data->Bindings.load(std::memory_order_acquire); binding; binding = binding->Next)
+    {
+        if (binding->Schema == Argument.Schema && Argument.Index < binding->Positions.size())
+            return binding->Positions[Argument.Index];
+    }
+
+    // slots added to the schema since any binding was made are picked up here
+    return Bind(*Argument.Schema).Positions[Argument.Index];
+}
+
+const xlw::ArgumentList::Binding& xlw::ArgumentList::Bind(const ArgumentSchema& schema) const
+{
+    Binding* binding = new Binding;
+    binding->Schema = &schema;
+    binding->Positions.assign(schema.Size(), ArgumentNameIndex::npos);
+    for (size_t position = 0; position < Data->Names.Size(); ++position)
+    {
+        size_t index = schema.Find(Data->Names.Key(position));
+        if (index != ArgumentNameIndex::npos)
+            binding->Positions[index] = position;
+    }
+
+    // two threads binding at once both push, which only costs a little memory
+    binding->Next = Data->Bindings.load(std::memory_order_relaxed);
+    while (!Data->Bindings.compare_exchange_weak(binding->Next, binding, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+
+    return *binding;
 }
 
-void xlw::ArgumentList::UseArgumentName(const std::string& ArgumentName)
+xlw::ArgumentList::Values::Values() : Bindings(0)
 {
-    std::map<std::string,bool>::iterator it= ArgumentsUsed.find(ArgumentName);
-    it->second =true;
+}
+
+xlw::ArgumentList::Values::Values(const Values& theOther)
+    : StructureName(theOther.StructureName),
+      ArgumentNames(theOther.ArgumentNames),
+      Names(theOther.Names),
+      ValuePositions(theOther.ValuePositions),
+      DoubleArguments(theOther.DoubleArguments),
+      StringArguments(theOther.StringArguments),
+      BoolArguments(theOther.BoolArguments),
+      CellArguments(theOther.CellArguments),
+      Bindings(0)
+{
+}
+
+xlw::ArgumentList::Values::~Values()
+{
+    ClearBindings();
+}
+
+void xlw::ArgumentList::Values::ClearBindings()
+{
+    Binding* binding = Bindings.exchange(0);
+    while (binding)
+    {
+        Binding* next = binding->Next;
+        delete binding;
+        binding = next;
+    }
+}
+
+std::string xlw::ArgumentList::NameOf(const std::string& ArgumentName)
+{
+    return StringUtilities::toLower(ArgumentName);
+}
+
+std::string xlw::ArgumentList::NameOf(ArgumentSlot Argument)
+{
+    return Argument.Schema->Name(Argument.Index);
 }
 
 std::string xlw::ArgumentList::GetStringArgumentValue(const std::string& ArgumentName)
 {
-    return GetArgumentValueInternal(ArgumentName, StringArguments);
+    return Data->StringArguments[UseArgument(ArgumentName, string)];
 }
 
 unsigned long xlw::ArgumentList::GetULArgumentValue(const std::string& ArgumentName)
 {
-    return static_cast<unsigned long>(GetArgumentValueInternal(ArgumentName, DoubleArguments));
+    return static_cast<unsigned long>(Data->DoubleArguments[UseArgument(ArgumentName, number)]);
 }
 
 double xlw::ArgumentList::GetDoubleArgumentValue(const std::string& ArgumentName)
 {
-    return GetArgumentValueInternal(ArgumentName, DoubleArguments);
+    return Data->DoubleArguments[UseArgument(ArgumentName, number)];
 }
 
 const xlw::CellMatrix& xlw::ArgumentList::GetArrayArgumentValueInternal(const std::string& ArgumentName)
 {
-    return GetArgumentValueInternal(ArgumentName, ArrayArguments);
+    return Data->CellArguments[UseArgument(ArgumentName, vector)];
 }
 
 const xlw::CellMatrix& xlw::ArgumentList::GetMatrixArgumentValueInternal(const std::string& ArgumentName)
 {
-    return GetArgumentValueInternal(ArgumentName, MatrixArguments);
+    return Data->CellArguments[UseArgument(ArgumentName, matrix)];
 }
 
 bool xlw::ArgumentList::GetBoolArgumentValue(const std::string& ArgumentName)
 {
-    return GetArgumentValueInternal(ArgumentName, BoolArguments);
+    return Data->BoolArguments[UseArgument(ArgumentName, boolean)];
 }
 
 xlw::ArgumentList xlw::ArgumentList::GetArgumentListArgumentValue(const std::string& ArgumentName)
 {
-    return ArgumentList(GetArgumentValueInternal(ArgumentName, ListArguments),ArgumentName);
+    return ArgumentList(Data->CellArguments[UseArgument(ArgumentName, list)],ArgumentName);
 }
 
 xlw::CellMatrix xlw::ArgumentList::GetCellsArgumentValue(const std::string& ArgumentName)
 {
-    return GetArgumentValueInternal(ArgumentName, CellArguments);
+    return Data->CellArguments[UseArgument(ArgumentName, cells)];
+}
+
+bool xlw::ArgumentList::IsArgumentPresent(const std::string& ArgumentName) const
+{
+    return Find(ArgumentName) != ArgumentNameIndex::npos;
+}
+
+std::string xlw::ArgumentList::GetStringArgumentValue(ArgumentSlot Argument)
+{
+    return Data->StringArguments[UseArgument(Argument, string)];
 }
 
-bool xlw::ArgumentList::IsArgumentPresent(const std::string& ArgumentName_) const
+unsigned long xlw::ArgumentList::GetULArgumentValue(ArgumentSlot Argument)
 {
-    return (Names.find(StringUtilities::toLower(ArgumentName_)) != Names.end());
+    return static_cast<unsigned long>(GetDoubleArgumentValue(Argument));
+}
+
+double xlw::ArgumentList::GetDoubleArgumentValue(ArgumentSlot Argument)
+{
+    return Data->DoubleArguments[UseArgument(Argument, number)];
+}
+
+const xlw::CellMatrix& xlw::ArgumentList::GetArrayArgumentValueInternal(ArgumentSlot Argument)
+{
+    return Data->CellArguments[UseArgument(Argument, vector)];
+}
+
+const xlw::CellMatrix& xlw::ArgumentList::GetMatrixArgumentValueInternal(ArgumentSlot Argument)
+{
+    return Data->CellArguments[UseArgument(Argument, matrix)];
+}
+
+bool xlw::ArgumentList::GetBoolArgumentValue(ArgumentSlot Argument)
+{
+    return Data->BoolArguments[UseArgument(Argument, boolean)];
+}
+
+xlw::ArgumentList xlw::ArgumentList::GetArgumentListArgumentValue(ArgumentSlot Argument)
+{
+    return ArgumentList(Data->CellArguments[UseArgument(Argument, list)],NameOf(Argument));
+}
+
+xlw::CellMatrix xlw::ArgumentList::GetCellsArgumentValue(ArgumentSlot Argument)
+{
+    return Data->CellArguments[UseArgument(Argument, cells)];
+}
+
+bool xlw::ArgumentList::IsArgumentPresent(ArgumentSlot Argument) const
+{
+    return Find(Argument) != ArgumentNameIndex::npos;
 }
 
 void xlw::ArgumentList::CheckAllUsed(const std::string& ErrorId) const
 {
-    std::string unusedList;
+    std::vector<std::string> unused;
 
-    for (std::map<std::string,bool>::const_iterator it = ArgumentsUsed.begin();
-        it != ArgumentsUsed.end(); it++)
+    for (size_t position = 0; position < Used.size(); ++position)
     {
-        if (!it->second)
-            unusedList+=it->first + std::string(", ");
+        if (!Used[position])
+            unused.push_back(Data->ArgumentNames[position].first);
     }
 
-    if (unusedList !="")
-        THROW_XLW("Unused arguments in " << ErrorId << " " << StructureName << " " << unusedList);
+    if (!unused.empty())
+    {
+        std::sort(unused.begin(), unused.end());
+
+        std::string unusedList;
+        for (size_t i = 0; i < unused.size(); ++i)
+            unusedList+=unused[i] + std::string(", ");
 
+        THROW_XLW("Unused arguments in " << ErrorId << " " << Data->StructureName << " " << unusedList);
+    }
 }
 
 void xlw::ArgumentList::GenerateThrow(std::string message, size_t row, size_t column)
 {
-    THROW_XLW(StructureName << " " << message << " row:" << static_cast<unsigned long>(row) << "; column:" << static_cast<unsigned long>(column));
+    THROW_XLW(Data->StructureName << " " << message << " row:" << static_cast<unsigned long>(row) << "; column:" << static_cast<unsigned long>(column));
 }
 
-xlw::ArgumentList::ArgumentList(std::string name) : StructureName(name)
+xlw::ArgumentList::ArgumentList(std::string name) : Data(new Values)
 {
+    Data->StructureName = name;
 
 }
 
 xlw::CellMatrix xlw::ArgumentList::AllData() const
 {
     CellMatrix results(1,1);
-    results(0,0)= StructureName;
-
-    {for (std::map<std::string,double>::const_iterator it= DoubleArguments.begin();
-            it != DoubleArguments.end(); it++)
-    {
-         CellMatrix tmp(2,1);
-         tmp(0,0) = it->first;
-         tmp(1,0) = it->second;
-         results.PushBottom(tmp);
-    }}
-
-    {for (std::map<std::string,CellMatrix>::const_iterator it= ArrayArguments.begin();
-            it != ArrayArguments.end(); it++)
-    {
-         CellMatrix tmp(3+it->second.RowsInStructure(),1);
-         tmp(0,0) = it->first;
-         tmp(1,0) = std::string("array");
-         tmp(2,0) = static_cast<double>(it->second.RowsInStructure());
-         for (size_t i=0; i < it->second.RowsInStructure(); i++)
-             tmp(i+3,0)=it->second(i, 0);
-         results.PushBottom(tmp);
-    }}
-
-    {for (std::map<std::string,CellMatrix>::const_iterator it= MatrixArguments.begin();
-            it != MatrixArguments.end(); it++)
-    {
-         CellMatrix tmp(3+it->second.RowsInStructure(),std::max(size_t(2), it->second.ColumnsInStructure()));
-         tmp(0,0) = it->first;
-         tmp(1,0) = std::string("matrix");
-         tmp(2,0) = static_cast<double>(it->second.RowsInStructure());
-         tmp(2,1) = static_cast<double>(it->second.ColumnsInStructure());
-         for (size_t i=0; i < it->second.RowsInStructure(); i++)
-             for (size_t j=0; j < it->second.ColumnsInStructure(); j++)
-                 tmp(i+3,j)=it->second(i,j);
-         results.PushBottom(tmp);
-    }}
-
-    {for (std::map<std::string,std::string>::const_iterator it= StringArguments.begin();
-            it != StringArguments.end(); it++)
-    {
-         CellMatrix tmp(2,1);
-         tmp(0,0) = it->first;
-         tmp(1,0) = it->second;
-         results.PushBottom(tmp);
-    }}
-
-    {for (std::map<std::string,bool>::const_iterator it= BoolArguments.begin();
-            it != BoolArguments.end(); it++)
-    {
-         CellMatrix tmp(2,1);
-         tmp(0,0) = it->first;
-         tmp(1,0) = it->second;
-         results.PushBottom(tmp);
-    }}
-
-    {for (std::map<std::string,CellMatrix>::const_iterator it= CellArguments.begin();
-            it != CellArguments.end(); it++)
-    {
-        CellMatrix tmp(3+it->second.RowsInStructure(),std::max(size_t(2),it->second.ColumnsInStructure()));
-         tmp(0,0) = it->first;
-         tmp(1,0) = std::string("cells");
-         tmp(2,0) = static_cast<double>(it->second.RowsInStructure());
-         tmp(2,1) = static_cast<double>(it->second.ColumnsInStructure());
-         for (size_t i=0; i < it->second.RowsInStructure(); i++)
-             for (size_t j=0; j < it->second.ColumnsInStructure(); j++)
-                 tmp(i+3,j)=it->second(i,j);
-         results.PushBottom(tmp);
-    }}
-
-    {for (std::map<std::string,CellMatrix>::const_iterator it= ListArguments.begin();
-        it != ListArguments.end(); it++)
-    {
-        CellMatrix tmp(3+it->second.RowsInStructure(),std::max(size_t(2),it->second.ColumnsInStructure()));
-         tmp(0,0) = it->first;
-         tmp(1,0) = std::string("list");
-         tmp(2,0) = static_cast<double>(it->second.RowsInStructure());
-         tmp(2,1) = static_cast<double>(it->second.ColumnsInStructure());
-         for (size_t i=0; i < it->second.RowsInStructure(); i++)
-             for (size_t j=0; j < it->second.ColumnsInStructure(); j++)
-                 tmp(i+3,j)=it->second(i,j);
-         results.PushBottom(tmp);
-    }}
+    results(0,0)= Data->StructureName;
+
+    std::vector<size_t> order(Data->ArgumentNames.size());
+    for (size_t i=0; i < order.size(); i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), AllDataOrder(Data->ArgumentNames));
 
+    for (size_t k=0; k < order.size(); k++)
+    {
+        const std::string& name = Data->ArgumentNames[order[k]].first;
+        ArgumentType type = Data->ArgumentNames[order[k]].second;
+        size_t value = Data->ValuePositions[order[k]];
 
+        if (type == number || type == string || type == boolean)
+        {
+            CellMatrix tmp(2,1);
+            tmp(0,0) = name;
+            if (type == number)
+                tmp(1,0) = Data->DoubleArguments[value];
+            else if (type == string)
+                tmp(1,0) = Data->StringArguments[value];
+            else
+                tmp(1,0) = static_cast<bool>(Data->BoolArguments[value]);
+            results.PushBottom(tmp);
+        }
+        else if (type == vector)
+        {
+            const CellMatrix& values = Data->CellArguments[value];
+            CellMatrix tmp(3+values.RowsInStructure(),1);
+            tmp(0,0) = name;
+            tmp(1,0) = std::string("array");
+            tmp(2,0) = static_cast<double>(values.RowsInStructure());
+            for (size_t i=0; i < values.RowsInStructure(); i++)
+                tmp(i+3,0)=values(i, 0);
+            results.PushBottom(tmp);
+        }
+        else
+        {
+            const CellMatrix& values = Data->CellArguments[value];
+            CellMatrix tmp(3+values.RowsInStructure(),std::max(size_t(2),values.ColumnsInStructure()));
+            tmp(0,0) = name;
+            tmp(1,0) = std::string(type == matrix ? "matrix" : type == cells ? "cells" : "list");
+            tmp(2,0) = static_cast<double>(values.RowsInStructure());
+            tmp(2,1) = static_cast<double>(values.ColumnsInStructure());
+            for (size_t i=0; i < values.RowsInStructure(); i++)
+                for (size_t j=0; j < values.ColumnsInStructure(); j++)
+                    tmp(i+3,j)=values(i,j);
+            results.PushBottom(tmp);
+        }
+    }
 
     return results;
 }
@@ -573,3 +1121,53 @@ bool xlw::ArgumentList::GetIfPresent(const std::string& ArgumentName,
     ArgumentValue = GetArgumentListArgumentValue(ArgumentName);
     return true;
 }
+
+bool xlw::ArgumentList::GetIfPresent(ArgumentSlot Argument,
+                                unsigned long& ArgumentValue)
+{
+    if (!IsArgumentPresent(Argument))
+        return false;
+
+    ArgumentValue = GetULArgumentValue(Argument);
+    return true;
+}
+
+bool xlw::ArgumentList::GetIfPresent(ArgumentSlot Argument,
+                                double& ArgumentValue)
+{
+    if (!IsArgumentPresent(Argument))
+        return false;
+
+    ArgumentValue = GetDoubleArgumentValue(Argument);
+    return true;
+}
+
+bool xlw::ArgumentList::GetIfPresent(ArgumentSlot Argument,
+                                bool& ArgumentValue)
+{
+    if (!IsArgumentPresent(Argument))
+        return false;
+
+    ArgumentValue = GetBoolArgumentValue(Argument);
+    return true;
+}
+
+bool xlw::ArgumentList::GetIfPresent(ArgumentSlot Argument,
+                                CellMatrix& ArgumentValue)
+{
+    if (!IsArgumentPresent(Argument))
+        return false;
+
+    ArgumentValue = GetCellsArgumentValue(Argument);
+    return true;
+}
+
+bool xlw::ArgumentList::GetIfPresent(ArgumentSlot Argument,
+                                ArgumentList& ArgumentValue)
+{
+    if (!IsArgumentPresent(Argument))
+        return false;
+
+    ArgumentValue = GetArgumentListArgumentValue(Argument);
+    return true;
+}
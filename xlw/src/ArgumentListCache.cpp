@@ -0,0 +1,202 @@
+/*
+ This file is part of XLW, a free-software/open-source C++ wrapper of the
+ Excel C API - https://xlw.github.io/
+
+ XLW is free software: you can redistribute it and/or modify it under the
+ terms of the XLW license.  You should have received a copy of the
+ license along with this program; if not, please email xlw-users@lists.sf.net
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*!
+\file ArgumentListCache.cpp
+\brief Implements the ArgumentListCache class.
+*/
+
+// $Id$
+
+#include <xlw/ArgumentListCache.h>
+#include <xlw/ArgList.h>
+#include <xlw/CriticalSection.h>
+#include <atomic>
+#include <list>
+#include <unordered_map>
+#include <cstring>
+
+namespace
+{
+    struct KeyHash
+    {
+        size_t operator()(const std::string& key) const
+        {
+            // FNV-1a taken a word at a time, with a shift so the high
+            // bytes of each word reach the low bits the buckets use
+            unsigned long long hash = 14695981039346656037ULL;
+            const unsigned long long prime = 1099511628211ULL;
+            const char* data = key.data();
+            size_t i = 0;
+            for (; i + sizeof(hash) <= key.size(); i += sizeof(hash))
+            {
+                unsigned long long word;
+                memcpy(&word, data + i, sizeof(word));
+                hash = (hash ^ word) * prime;
+                hash ^= hash >> 29;
+            }
+            for (; i < key.size(); ++i)
+            {
+                hash = (hash ^ static_cast<unsigned char>(data[i])) * prime;
+            }
+            return static_cast<size_t>(hash ^ (hash >> 32));
+        }
+    };
+
+    typedef std::list<const std::string*> Recent;
+
+    struct Entry
+    {
+        Entry(const xlw::ArgumentList& list_) : list(list_) {}
+        xlw::ArgumentList list;
+        Recent::iterator recent;
+    };
+
+    typedef std::unordered_map<std::string, Entry, KeyHash> Lists;
+
+    // all only touched under the lock, apart from the capacity which
+    // the ArgumentList constructor checks first
+    Lists lists;
+    // keys of the lists, most recently used first
+    Recent recent;
+    std::atomic<size_t> capacity(0);
+    xlw::ArgumentListCache::Statistics statistics;
+
+    xlw::CriticalSection& Lock()
+    {
+        static xlw::CriticalSection criticalSection;
+        return criticalSection;
+    }
+
+    void EvictTo(size_t size)
+    {
+        while (lists.size() > size)
+        {
+            lists.erase(*recent.back());
+            recent.pop_back();
+            ++statistics.evictions;
+        }
+    }
+
+    template<class T>
+    void Append(std::string& key, const T& value)
+    {
+        key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+}
+
+void xlw::ArgumentListCache::SetCapacity(size_t maximum)
+{
+    ProtectInScope protect(Lock());
+    capacity.store(maximum, std::memory_order_relaxed);
+    EvictTo(maximum);
+}
+
+size_t xlw::ArgumentListCache::Capacity()
+{
+    return capacity.load(std::memory_order_relaxed);
+}
+
+void xlw::ArgumentListCache::Clear()
+{
+    ProtectInScope protect(Lock());
+    lists.clear();
+    recent.clear();
+}
+
+xlw::ArgumentListCache::Statistics xlw::ArgumentListCache::GetStatistics()
+{
+    ProtectInScope protect(Lock());
+    Statistics result(statistics);
+    result.size = lists.size();
+    return result;
+}
+
+void xlw::ArgumentListCache::MakeKey(const XLOPER12* cells, size_t rows, size_t columns, std::string& key)
+{
+    key.clear();
+    key.reserve(2 * sizeof(size_t) + rows * columns * (1 + sizeof(double)));
+    Append(key, rows);
+    Append(key, columns);
+    for (size_t i = 0; i < rows * columns; ++i)
+    {
+        const XLOPER12& cell = cells[i];
+        switch (cell.xltype & 0xFFF)
+        {
+        case xltypeNum:
+            key += 'n';
+            Append(key, cell.val.num);
+            break;
+        case xltypeInt:
+            // read the same as a number
+            key += 'n';
+            Append(key, static_cast<double>(cell.val.w));
+            break;
+        case xltypeStr:
+            key += 's';
+            key.append(reinterpret_cast<const char*>(cell.val.str), (static_cast<size_t>(cell.val.str[0]) + 1) * sizeof(wchar_t));
+            break;
+        case xltypeBool:
+            key += 'b';
+            key += cell.val.xbool ? '1' : '0';
+            break;
+        case xltypeErr:
+            key += 'e';
+            Append(key, cell.val.err);
+            break;
+        case xltypeNil:
+        case xltypeMissing:
+            key += '_';
+            break;
+        default:
+            // can't be parsed, but keeps keys for different cells apart
+            key += '?';
+            Append(key, cell.xltype);
+            break;
+        }
+    }
+}
+
+bool xlw::ArgumentListCache::Find(const std::string& key, ArgumentList& list)
+{
+    ProtectInScope protect(Lock());
+    Lists::iterator it = lists.find(key);
+    if (it == lists.end())
+    {
+        ++statistics.misses;
+        return false;
+    }
+    ++statistics.hits;
+    recent.splice(recent.begin(), recent, it->second.recent);
+    list = it->second.list;
+    return true;
+}
+
+void xlw::ArgumentListCache::Insert(const std::string& key, const ArgumentList& list)
+{
+    ProtectInScope protect(Lock());
+    size_t maximum = capacity.load(std::memory_order_relaxed);
+    if (maximum == 0)
+    {
+        return;
+    }
+    // another thread may have parsed the same cells meanwhile
+    std::pair<Lists::iterator, bool> inserted = lists.insert(Lists::value_type(key, Entry(list)));
+    if (!inserted.second)
+    {
+        return;
+    }
+    recent.push_front(&inserted.first->first);
+    inserted.first->second.recent = recent.begin();
+    EvictTo(maximum);
+}
@@ -0,0 +1,148 @@
+/*
+ This file is part of XLW, a free-software/open-source C++ wrapper of the
+ Excel C API - https://xlw.github.io/
+
+ XLW is free software: you can redistribute it and/or modify it under the
+ terms of the XLW license.  You should have received a copy of the
+ license along with this program; if not, please email xlw-users@lists.sf.net
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*!
+\file ArrayPacker.cpp
+\brief Implements the ArrayPacker class.
+*/
+
+// $Id$
+
+#include <xlw/ArrayPacker.h>
+#include <xlw/TempMemory.h>
+#include <xlw/PascalStringConversions.h>
+#include <xlw/macros.h>
+#include <xlw/XlfException.h>
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    // the same limits as PascalStringConversions
+    const size_t MaxNarrowLength = 32767;
+    const size_t MaxWideLength = 32766;
+
+    const size_t MaxRows = 1048576;
+    const size_t MaxColumns = 16384;
+}
+
+xlw::ArrayPacker::ArrayPacker(size_t rows, size_t columns)
+    : rows_(rows), columns_(columns), elements_(0), strings_(0)
+{
+    if (rows_ > 0 && columns_ > 0)
+    {
+        if (columns_ > MaxColumns)
+        {
+            std::cerr << "Truncating columns to 16384" << std::endl;
+            columns_ = MaxColumns;
+        }
+        if (rows_ > MaxRows)
+        {
+            std::cerr << "Truncating rows to 1048576" << std::endl;
+            rows_ = MaxRows;
+        }
+    }
+    else
+    {
+        rows_ = 0;
+        columns_ = 0;
+    }
+}
+
+size_t xlw::ArrayPacker::StringSpace(const std::string& value)
+{
+    // multibyte characters only ever give fewer wide characters
+    return std::min(value.size(), MaxNarrowLength) + 2;
+}
+
+size_t xlw::ArrayPacker::StringSpace(const std::wstring& value)
+{
+    return std::min(value.size(), MaxWideLength) + 2;
+}
+
+size_t xlw::ArrayPacker::StringSpace(const wchar_t* pascalString)
+{
+    return static_cast<size_t>(pascalString[0]) + 2;
+}
+
+void xlw::ArrayPacker::Allocate(size_t stringSpace)
+{
+    size_t elementBytes = rows_ * columns_ * sizeof(XLOPER12);
+    if (elementBytes == 0)
+    {
+        return;
+    }
+    char* block = TempMemory::GetMemoryUninitialized<char>(elementBytes + stringSpace * sizeof(wchar_t));
+    elements_ = reinterpret_cast<XLOPER12*>(block);
+    strings_ = stringSpace ? reinterpret_cast<wchar_t*>(block + elementBytes) : 0;
+}
+
+void xlw::ArrayPacker::SetString(XLOPER12& element, const std::string& value, wchar_t*& next)
+{
+    size_t n(std::min(value.size(), MaxNarrowLength));
+    if (n < value.size())
+    {
+        std::cerr << XLW__HERE__ << "String truncated to 32767 bytes" << std::endl;
+    }
+    // any room left over by multibyte characters goes unused
+    if (n > 0 && !PascalStringConversions::WidenAscii(value.c_str(), n, next + 1))
+    {
+        n = MultiByteToWideChar(CP_ACP, 0, value.c_str(), (int)n, next + 1, (int)n);
+    }
+    next[0] = static_cast<wchar_t>(n);
+    next[n + 1] = 0;
+    element.xltype = xltypeStr;
+    element.val.str = next;
+    next += StringSpace(value);
+}
+
+void xlw::ArrayPacker::SetString(XLOPER12& element, const std::wstring& value, wchar_t*& next)
+{
+    size_t n(std::min(value.size(), MaxWideLength));
+    if (n < value.size())
+    {
+        std::cerr << XLW__HERE__ << "String truncated to 32766 bytes" << std::endl;
+    }
+    std::copy(value.begin(), value.begin() + n, next + 1);
+    next[0] = static_cast<wchar_t>(n);
+    next[n + 1] = 0;
+    element.xltype = xltypeStr;
+    element.val.str = next;
+    next += n + 2;
+}
+
+void xlw::ArrayPacker::SetString(XLOPER12& element, const wchar_t* pascalString, wchar_t*& next)
+{
+    size_t n(static_cast<size_t>(pascalString[0]));
+    memcpy(next, pascalString, (n + 1) * sizeof(wchar_t));
+    next[n + 1] = 0;
+    element.xltype = xltypeStr;
+    element.val.str = next;
+    next += n + 2;
+}
+
+void xlw::ArrayPacker::Finish(LPXLOPER12 oper) const
+{
+    if (elements_)
+    {
+        oper->val.array.lparray = elements_;
+        oper->val.array.rows = static_cast<RW>(rows_);
+        oper->val.array.columns = static_cast<COL>(columns_);
+        oper->xltype = xltypeMulti;
+    }
+    else
+    {
+        oper->xltype = xltypeMissing;
+    }
+}
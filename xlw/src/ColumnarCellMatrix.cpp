@@ -0,0 +1,344 @@
+//
+//
+//                        ColumnarCellMatrix.cpp
+//
+//
+/*
+ This file is part of XLW, a free-software/open-source C++ wrapper of the
+ Excel C API - https://xlw.github.io/
+
+ XLW is free software: you can redistribute it and/or modify it under the
+ terms of the XLW license.  You should have received a copy of the
+ license along with this program; if not, please email xlw-users@lists.sf.net
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+#include <xlw/ColumnarCellMatrix.h>
+#include <xlw/xlcall32.h>
+#include <xlw/XlfException.h>
+#include <unordered_map>
+#include <algorithm>
+
+namespace
+{
+    enum ElementKinds
+    {
+        numberKind = 1, stringKind = 2, booleanKind = 4, otherKind = 8
+    };
+
+    // nil elements are empty cells so don't count
+    int ElementKind(const XLOPER12& element)
+    {
+        switch (element.xltype & 0xFFF)
+        {
+        case xltypeNum:
+        case xltypeInt:
+            return numberKind;
+        case xltypeStr:
+            return stringKind;
+        case xltypeBool:
+            return booleanKind;
+        case xltypeNil:
+            return 0;
+        case xltypeErr:
+            return otherKind;
+        default:
+            THROW_XLW("Unsupported type in CellMatrix conversion");
+        }
+    }
+
+    xlw::impl::FlatCellValue ElementAsCell(const XLOPER12& element)
+    {
+        switch (element.xltype & 0xFFF)
+        {
+        case xltypeNum:
+            return xlw::impl::FlatCellValue(element.val.num);
+        case xltypeInt:
+            return xlw::impl::FlatCellValue(static_cast<int>(element.val.w));
+        case xltypeStr:
+            return xlw::impl::FlatCellValue(std::wstring(element.val.str + 1, element.val.str + 1 + element.val.str[0]));
+        case xltypeBool:
+            return xlw::impl::FlatCellValue(element.val.xbool != 0);
+        case xltypeErr:
+            return xlw::impl::FlatCellValue(static_cast<unsigned long>(element.val.err), true);
+        case xltypeNil:
+            return xlw::impl::FlatCellValue();
+        default:
+            THROW_XLW("Unsupported type in CellMatrix conversion");
+        }
+    }
+}
+
+xlw::impl::ColumnarCellMatrix::ColumnarCellMatrix() : Data(), Rows(0)
+{
+}
+
+xlw::impl::ColumnarCellMatrix::ColumnarCellMatrix(size_t rows, size_t columns) : Data(columns), Rows(rows)
+{
+    for (size_t j(0); j < columns; ++j)
+    {
+        Data[j].Cells.resize(rows);
+    }
+}
+
+xlw::impl::ColumnarCellMatrix::ColumnarCellMatrix(const xloper12* elements, size_t rows, size_t columns)
+    : Data(columns), Rows(rows)
+{
+    // a single row is typed as it is, otherwise the first row may be a header
+    size_t firstTyped = rows > 1 ? 1 : 0;
+    std::unordered_map<std::wstring, unsigned int> ids;
+
+    for (size_t j(0); j < columns; ++j)
+    {
+        ColumnData& column(Data[j]);
+
+        int kinds = 0;
+        for (size_t i(firstTyped); i < rows; ++i)
+        {
+            kinds |= ElementKind(elements[i * columns + j]);
+        }
+
+        switch (kinds)
+        {
+        case numberKind:
+            column.Type = TypedColumn::number;
+            column.Numbers.resize(rows);
+            break;
+        case stringKind:
+            column.Type = TypedColumn::string;
+            column.StringIds.resize(rows);
+            break;
+        case booleanKind:
+            column.Type = TypedColumn::boolean;
+            column.Booleans.resize(rows);
+            break;
+        default:
+            // mixed or entirely empty
+            column.Cells.reserve(rows);
+            for (size_t i(0); i < rows; ++i)
+            {
+                column.Cells.push_back(ElementAsCell(elements[i * columns + j]));
+            }
+            continue;
+        }
+
+        column.Validity.resize((rows + 63) / 64);
+        ids.clear();
+        for (size_t i(0); i < rows; ++i)
+        {
+            const XLOPER12& element(elements[i * columns + j]);
+            int kind = ElementKind(element);
+            if (kind == 0)
+            {
+                continue;
+            }
+            if (kind != kinds)
+            {
+                // only the first row can get here
+                column.First = ElementAsCell(element);
+                continue;
+            }
+
+            column.Validity[i / 64] |= 1ULL << (i % 64);
+            switch (column.Type)
+            {
+            case TypedColumn::number:
+                column.Numbers[i] = (element.xltype & 0xFFF) == xltypeNum ? element.val.num : element.val.w;
+                break;
+            case TypedColumn::boolean:
+                column.Booleans[i] = element.val.xbool != 0;
+                break;
+            default:
+                {
+                    std::wstring value(element.val.str + 1, element.val.str + 1 + element.val.str[0]);
+                    std::unordered_map<std::wstring, unsigned int>::iterator it(ids.find(value));
+                    if (it == ids.end())
+                    {
+                        it = ids.insert(std::make_pair(value, static_cast<unsigned int>(column.Strings.size()))).first;
+                        column.Strings.push_back(value);
+                    }
+                    column.StringIds[i] = it->second;
+                }
+                break;
+            }
+        }
+    }
+}
+
+std::vector<xlw::impl::FlatCellValue>& xlw::impl::ColumnarCellMatrix::CellsOf(size_t j) const
+{
+    const ColumnData& column(Data[j]);
+    if (column.Type == TypedColumn::none || !column.Cells.empty() || Rows == 0)
+    {
+        return column.Cells;
+    }
+
+    std::vector<FlatCellValue> cells(Rows);
+    TypedColumn typed(Column(j));
+    for (size_t i(0); i < Rows; ++i)
+    {
+        if (!typed.IsValid(i))
+        {
+            continue;
+        }
+        switch (column.Type)
+        {
+        case TypedColumn::number:
+            cells[i] = FlatCellValue(typed.Numbers[i]);
+            break;
+        case TypedColumn::boolean:
+            cells[i] = FlatCellValue(typed.Booleans[i] != 0);
+            break;
+        default:
+            cells[i] = FlatCellValue(typed.Strings[typed.StringIds[i]]);
+            break;
+        }
+    }
+    if (!column.First.IsEmpty())
+    {
+        cells[0] = column.First;
+    }
+    column.Cells.swap(cells);
+    return column.Cells;
+}
+
+bool xlw::impl::ColumnarCellMatrix::IsSafeToShare() const
+{
+    if (Rows == 0)
+    {
+        return true;
+    }
+    for (size_t j(0); j < Data.size(); ++j)
+    {
+        if (Data[j].Type != TypedColumn::none && Data[j].Cells.empty())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void xlw::impl::ColumnarCellMatrix::PrepareForConcurrentRead() const
+{
+    for (size_t j(0); j < Data.size(); ++j)
+    {
+        CellsOf(j);
+    }
+}
+
+void xlw::impl::ColumnarCellMatrix::Untype(size_t j)
+{
+    CellsOf(j);
+    ColumnData& column(Data[j]);
+    column.Type = TypedColumn::none;
+    std::vector<double>().swap(column.Numbers);
+    std::vector<unsigned char>().swap(column.Booleans);
+    std::vector<unsigned int>().swap(column.StringIds);
+    std::vector<std::wstring>().swap(column.Strings);
+    std::vector<unsigned long long>().swap(column.Validity);
+    column.First.clear();
+}
+
+const xlw::CellValue& xlw::impl::ColumnarCellMatrix::operator()(size_t i, size_t j) const
+{
+    check(i, j);
+    return CellsOf(j)[i];
+}
+
+xlw::CellValue& xlw::impl::ColumnarCellMatrix::operator()(size_t i, size_t j)
+{
+    check(i, j);
+    if (Data[j].Type != TypedColumn::none)
+    {
+        Untype(j);
+    }
+    return Data[j].Cells[i];
+}
+
+xlw::TypedColumn xlw::impl::ColumnarCellMatrix::Column(size_t j) const
+{
+    TypedColumn result;
+    const ColumnData& column(Data.at(j));
+    if (column.Type == TypedColumn::none)
+    {
+        return result;
+    }
+    result.Type = column.Type;
+    result.Rows = Rows;
+    result.Numbers = column.Numbers.empty() ? 0 : &column.Numbers[0];
+    result.Booleans = column.Booleans.empty() ? 0 : &column.Booleans[0];
+    result.StringIds = column.StringIds.empty() ? 0 : &column.StringIds[0];
+    result.Strings = column.Strings.empty() ? 0 : &column.Strings[0];
+    result.Validity = column.Validity.empty() ? 0 : &column.Validity[0];
+    return result;
+}
+
+void xlw::impl::ColumnarCellMatrix::Reserve(size_t rows)
+{
+    for (size_t j(0); j < Data.size(); ++j)
+    {
+        if (Data[j].Type == TypedColumn::none)
+        {
+            Data[j].Cells.reserve(rows);
+        }
+    }
+}
+
+void xlw::impl::ColumnarCellMatrix::AppendRows(size_t rows)
+{
+    for (size_t j(0); j < Data.size(); ++j)
+    {
+        if (Data[j].Type != TypedColumn::none)
+        {
+            Untype(j);
+        }
+        Data[j].Cells.resize(Rows + rows);
+    }
+    Rows += rows;
+}
+
+void xlw::impl::ColumnarCellMatrix::PushBottom(const xlw::CellMatrix_pimpl_abstract & newRows)
+{
+    if (&newRows == this)
+    {
+        ColumnarCellMatrix copy(*this);
+        PushBottom(copy);
+        return;
+    }
+
+    if (newRows.ColumnsInStructure() > Data.size())
+    {
+        size_t oldColumns = Data.size();
+        Data.resize(newRows.ColumnsInStructure());
+        for (size_t j(oldColumns); j < Data.size(); ++j)
+        {
+            Data[j].Cells.resize(Rows);
+        }
+    }
+
+    size_t oldRows = Rows;
+    AppendRows(newRows.RowsInStructure());
+
+    try
+    {
+        for (size_t i(0); i < newRows.RowsInStructure(); ++i)
+        {
+            for (size_t j(0); j < newRows.ColumnsInStructure(); ++j)
+            {
+                static_cast<CellValue&>(Data[j].Cells[oldRows + i]) = newRows(i, j);
+            }
+        }
+    }
+    catch (...)
+    {
+        // take the new rows off again, shrinking doesn't allocate
+        for (size_t j(0); j < Data.size(); ++j)
+        {
+            Data[j].Cells.resize(oldRows);
+        }
+        Rows = oldRows;
+        throw;
+    }
+}
@@ -0,0 +1,244 @@
+//
+//
+//                        FlatCellMatrix.cpp
+//
+//
+/*
+ This file is part of XLW, a free-software/open-source C++ wrapper of the
+ Excel C API - https://xlw.github.io/
+
+ XLW is free software: you can redistribute it and/or modify it under the
+ terms of the XLW license.  You should have received a copy of the
+ license along with this program; if not, please email xlw-users@lists.sf.net
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+#include <xlw/FlatCellMatrix.h>
+#include <xlw/XlfException.h>
+#include <algorithm>
+
+
+xlw::impl::FlatCellValue::operator std::string() const
+{
+    return StringValue();
+}
+
+xlw::impl::FlatCellValue::operator std::wstring() const
+{
+    return WstringValue();
+}
+
+xlw::impl::FlatCellValue::operator bool() const
+{
+    return BooleanValue();
+}
+
+xlw::impl::FlatCellValue::operator double() const
+{
+    return NumericValue();
+}
+
+xlw::impl::FlatCellValue::operator unsigned long() const
+{
+    return static_cast<unsigned long>(NumericValue());
+}
+
+
+xlw::impl::FlatCellValue::FlatCellValue(const FlatCellValue & value) : Type(value.Type), Value(value.Value)
+{
+    if (HasText())
+    {
+        Value.String = new Text(*value.Value.String);
+    }
+}
+
+xlw::impl::FlatCellValue::FlatCellValue(const std::string& value) : Type(xlw::impl::FlatCellValue::string)
+{
+    Value.String = new Text(value);
+}
+
+xlw::impl::FlatCellValue::FlatCellValue(const std::wstring& value) : Type(xlw::impl::FlatCellValue::wstring)
+{
+    StringPool::Symbol interned(StringPool::InternsCellStrings() ? StringPool::TryIntern(value) : 0);
+    if (interned)
+    {
+        Type = symbol;
+        Value.Number = 0.0;
+        Value.Interned = interned;
+    }
+    else
+    {
+        // not interning, or the pool is full, so the cell owns the string
+        Value.String = new Text(value);
+    }
+}
+
+xlw::impl::FlatCellValue::FlatCellValue(unsigned long Code, bool Error) : Type(error)
+{
+    if (Error)
+    {
+        Value.Number = 0.0;
+        Value.Code = Code;
+    }
+    else
+    {
+        Type = number;
+        Value.Number = Code;
+    }
+}
+
+const std::string & xlw::impl::FlatCellValue::StringValue() const
+{
+    if (Type == string) {
+        return Value.String->Narrow;
+    } else if (Type == wstring) {
+        const Text& text(*Value.String);
+        std::string* made = text.MadeNarrow.load(std::memory_order_acquire);
+        if (!made) {
+            std::string* converted = new std::string(text.Wide.begin(), text.Wide.end());
+            if (text.MadeNarrow.compare_exchange_strong(made, converted, std::memory_order_acq_rel)) {
+                made = converted;
+            } else {
+                // another thread got there first
+                delete converted;
+            }
+        }
+        return *made;
+    } else if (Type == symbol) {
+        return StringPool::StringValue(Value.Interned);
+    } else {
+        THROW_XLW("non string cell asked to be a string");
+    }
+}
+
+const std::wstring& xlw::impl::FlatCellValue::WstringValue() const
+{
+    if (Type == wstring) {
+        return Value.String->Wide;
+    } else if (Type == string) {
+        const Text& text(*Value.String);
+        std::wstring* made = text.MadeWide.load(std::memory_order_acquire);
+        if (!made) {
+            // a byte at a time as unsigned characters, so non-ASCII bytes don't sign extend
+            std::wstring* converted = new std::wstring(text.Narrow.size(), L'\0');
+            for (size_t i = 0; i < text.Narrow.size(); ++i)
+                (*converted)[i] = static_cast<unsigned char>(text.Narrow[i]);
+            if (text.MadeWide.compare_exchange_strong(made, converted, std::memory_order_acq_rel)) {
+                made = converted;
+            } else {
+                delete converted;
+            }
+        }
+        return *made;
+    } else if (Type == symbol) {
+        return StringPool::WstringValue(Value.Interned);
+    } else {
+        THROW_XLW("non string cell asked to be a string");
+    }
+}
+
+xlw::StringPool::Symbol xlw::impl::FlatCellValue::SymbolValue() const
+{
+    if (Type != symbol)
+        THROW_XLW("non interned cell asked for its symbol");
+    return Value.Interned;
+}
+
+double xlw::impl::FlatCellValue::NumericValue() const
+{
+    if (Type != number)
+        THROW_XLW("non number cell asked to be a number");
+    return Value.Number;
+}
+
+bool xlw::impl::FlatCellValue::BooleanValue() const
+{
+    if (Type != boolean)
+        THROW_XLW("non boolean cell asked to be a bool");
+    return Value.Flag;
+}
+
+unsigned long xlw::impl::FlatCellValue::ErrorValue() const
+{
+    if (Type != error)
+        THROW_XLW("non error cell asked to be an error");
+    return Value.Code;
+}
+
+xlw::impl::FlatCellMatrix::FlatCellMatrix() : Cells(), Rows(0), Columns(0), ReservedRows(0)
+{
+}
+
+xlw::impl::FlatCellMatrix::FlatCellMatrix(size_t rows, size_t columns)
+    : Cells(rows * columns), Rows(rows), Columns(columns), ReservedRows(0)
+{
+}
+
+void xlw::impl::FlatCellMatrix::Reserve(size_t rows)
+{
+    ReservedRows = rows;
+    Cells.reserve(rows * Columns);
+}
+
+void xlw::impl::FlatCellMatrix::AppendRows(size_t rows)
+{
+    // resize grows the capacity geometrically so appending a row at a time is amortised constant
+    Cells.resize((Rows + rows) * Columns);
+    Rows += rows;
+}
+
+void xlw::impl::FlatCellMatrix::Widen(size_t newColumns)
+{
+    std::vector<FlatCellValue> temp;
+    temp.reserve(std::max(Rows, ReservedRows) * newColumns);
+    temp.resize(Rows * newColumns);
+    for (size_t i(0); i < Rows; ++i)
+    {
+        std::move(Cells.begin() + i * Columns, Cells.begin() + (i + 1) * Columns, temp.begin() + i * newColumns);
+    }
+    Cells.swap(temp);
+    Columns = newColumns;
+}
+
+void xlw::impl::FlatCellMatrix::PushBottom(const xlw::CellMatrix_pimpl_abstract & newRows)
+{
+    if (&newRows == this)
+    {
+        FlatCellMatrix copy(*this);
+        PushBottom(copy);
+        return;
+    }
+
+    if (newRows.ColumnsInStructure() > Columns)
+    {
+        Widen(newRows.ColumnsInStructure());
+    }
+
+    size_t oldRows = Rows;
+    AppendRows(newRows.RowsInStructure());
+
+    const FlatCellMatrix* flatRows = dynamic_cast<const FlatCellMatrix*>(&newRows);
+    try
+    {
+        for (size_t i(0); i < newRows.RowsInStructure(); ++i)
+        {
+            for (size_t j(0); j < newRows.ColumnsInStructure(); ++j)
+            {
+                FlatCellValue& target(Cells[(oldRows + i) * Columns + j]);
+                if (flatRows)
+                    target = flatRows->Cells[i * flatRows->Columns + j];
+                else
+                    static_cast<CellValue&>(target) = newRows(i, j);
+            }
+        }
+    }
+    catch (...)
+    {
+        // take the new rows off again, shrinking doesn't allocate
+        Cells.resize(oldRows * Columns);
+        Rows = oldRows;
+        throw;
+    }
+}
@@ -77,102 +77,113 @@ xlw::impl::MJCellValue::operator bool() const
 {
     if (Type != boolean)
         THROW_XLW("non boolean cell asked to be a bool");
-    return ValueAsBool;
+    return Value.Bool;
 }
 
 xlw::impl::MJCellValue::operator double() const
 {
     if (Type != number)
         THROW_XLW("non number cell asked to be a number");
-    return ValueAsNumeric;
+    return Value.Numeric;
 }
 
 xlw::impl::MJCellValue::operator unsigned long() const
 {
     if (Type != number)
         THROW_XLW("non number cell asked to be a number");
-    return static_cast<unsigned long>(ValueAsNumeric);
+    return static_cast<unsigned long>(Value.Numeric);
 }
 
 
+// the narrow form isn't copied, the copy makes its own if it is asked for
 xlw::impl::MJCellValue::MJCellValue(const MJCellValue & value) : Type(value.Type),
-	ValueAsNumeric(value.ValueAsNumeric), ValueAsBool(value.ValueAsBool), ValueAsErrorCode(value.ValueAsErrorCode)
+	Value(value.Value), ValueAsWstring(value.ValueAsWstring), ValueAsString(0)
 {
-	if(Type==xlw::impl::MJCellValue::string)
-	{
-		ValueAsString.reset(new std::string(*value.ValueAsString));
-	}
-	if(Type==xlw::impl::MJCellValue::wstring)
-	{
-		ValueAsWstring.reset(new std::wstring(*value.ValueAsWstring));
-	}
-
 }
 
 xlw::impl::MJCellValue::MJCellValue(const std::string& value) : Type(xlw::impl::MJCellValue::string),
-ValueAsString(new std::string(value)),ValueAsNumeric(0.0), ValueAsBool(false), ValueAsErrorCode(0)
+ValueAsWstring(value.size(), L'\0'), ValueAsString(0)
 {
-
+    Value.Numeric = 0.0;
+    for (size_t i = 0; i < value.size(); ++i)
+        ValueAsWstring[i] = static_cast<unsigned char>(value[i]);
 }
 
 xlw::impl::MJCellValue::MJCellValue(const std::wstring& value) : Type(xlw::impl::MJCellValue::wstring),
-ValueAsWstring(new std::wstring(value)), ValueAsNumeric(0.0), ValueAsBool(false), ValueAsErrorCode(0)
+ValueAsWstring(value), ValueAsString(0)
 {
-
+    Value.Numeric = 0.0;
 }
 
-
-xlw::impl::MJCellValue::MJCellValue(double Number): Type(xlw::impl::MJCellValue::number),
-ValueAsNumeric(Number), ValueAsBool(false), ValueAsErrorCode(0)
+xlw::impl::MJCellValue::~MJCellValue()
 {
-
+    delete ValueAsString.load(std::memory_order_relaxed);
 }
 
-xlw::impl::MJCellValue::MJCellValue(int i): Type(xlw::impl::MJCellValue::number),
-ValueAsNumeric(i), ValueAsBool(false), ValueAsErrorCode(0)
+xlw::impl::MJCellValue::MJCellValue(double Number): Type(xlw::impl::MJCellValue::number), ValueAsString(0)
 {
+    Value.Numeric = Number;
+}
 
+xlw::impl::MJCellValue::MJCellValue(int i): Type(xlw::impl::MJCellValue::number), ValueAsString(0)
+{
+    Value.Numeric = i;
 }
 
-xlw::impl::MJCellValue::MJCellValue(unsigned long Code, bool Error): Type(error),
-ValueAsNumeric(Code), ValueAsBool(false), ValueAsErrorCode(Code)
+xlw::impl::MJCellValue::MJCellValue(unsigned long Code, bool Error): Type(error), ValueAsString(0)
 {
-    if (!Error)
+    Value.Numeric = 0.0;
+    if (Error)
+    {
+        Value.ErrorCode = Code;
+    }
+    else
+    {
         Type = number;
+        Value.Numeric = Code;
+    }
 }
 
 xlw::impl::MJCellValue::MJCellValue(bool TrueFalse)
- : Type(xlw::impl::MJCellValue::boolean),ValueAsNumeric(0.0), ValueAsBool(TrueFalse), ValueAsErrorCode(0)
+ : Type(xlw::impl::MJCellValue::boolean), ValueAsString(0)
 {
+    Value.Numeric = 0.0;
+    Value.Bool = TrueFalse;
 }
 
-xlw::impl::MJCellValue::MJCellValue(): Type(xlw::impl::MJCellValue::empty),
-ValueAsNumeric(0.0), ValueAsBool(false), ValueAsErrorCode(0)
+xlw::impl::MJCellValue::MJCellValue(): Type(xlw::impl::MJCellValue::empty), ValueAsString(0)
 {
+    Value.Numeric = 0.0;
 }
 
 const  std::string & xlw::impl::MJCellValue::StringValue() const
 {
-    if (Type == string) {
-        return *ValueAsString;
-    } else if (Type == wstring) {
-        ValueAsString.reset(new std::string(ValueAsWstring->begin(), ValueAsWstring->end()));
-        return *ValueAsString;
-    } else {
+    if (Type != string && Type != wstring)
         THROW_XLW("non string cell asked to be a string");
+
+    std::string* narrow = ValueAsString.load(std::memory_order_acquire);
+    if (!narrow)
+    {
+        // gives back the bytes of a narrow string exactly as they were widened
+        std::string* made = new std::string(ValueAsWstring.begin(), ValueAsWstring.end());
+        if (ValueAsString.compare_exchange_strong(narrow, made, std::memory_order_acq_rel))
+        {
+            narrow = made;
+        }
+        else
+        {
+            // another thread got there first
+            delete made;
+        }
     }
+    return *narrow;
 }
 
 const std::wstring& xlw::impl::MJCellValue::WstringValue() const
 {
-    if (Type == wstring) {
-        return *ValueAsWstring;
-    } else if (Type == string) {
-        ValueAsWstring.reset(new std::wstring(ValueAsString->begin(), ValueAsString->end()));
-        return *ValueAsWstring;
-    } else {
+    if (Type != string && Type != wstring)
         THROW_XLW("non string cell asked to be a string");
-    }
+    return ValueAsWstring;
 }
 
 double xlw::impl::MJCellValue::NumericValue() const
@@ -180,7 +191,7 @@ double xlw::impl::MJCellValue::NumericValue() const
 
     if (Type != number)
         THROW_XLW("non number cell asked to be a number");
-    return ValueAsNumeric;
+    return Value.Numeric;
 }
 
 bool xlw::impl::MJCellValue::BooleanValue() const
@@ -189,7 +200,7 @@ bool xlw::impl::MJCellValue::BooleanValue() const
     if (Type != boolean)
         THROW_XLW("non boolean cell asked to be a bool");
 
-    return ValueAsBool;
+    return Value.Bool;
 }
 
 unsigned long xlw::impl::MJCellValue::ErrorValue() const
@@ -197,7 +208,7 @@ unsigned long xlw::impl::MJCellValue::ErrorValue() const
     if (Type != error)
         THROW_XLW("non error cell asked to be an error");
 
-    return ValueAsErrorCode;
+    return Value.ErrorCode;
 }
 
 xlw::impl::MJCellMatrix::MJCellMatrix() : Cells(0), Rows(0), Columns(0)
@@ -230,29 +241,58 @@ size_t xlw::impl::MJCellMatrix::ColumnsInStructure() const
     return Columns;
 }
 
-void xlw::impl::MJCellMatrix::PushBottom(const xlw::CellMatrix_pimpl_abstract & newRows)
+void xlw::impl::MJCellMatrix::Reserve(size_t rows)
 {
-	size_t newColumns = std::max(this->ColumnsInStructure(), newRows.ColumnsInStructure());
+    Cells.reserve(rows);
+}
 
-	MJCellMatrix temp(this->RowsInStructure()+newRows.RowsInStructure(),newColumns);
+void xlw::impl::MJCellMatrix::AppendRows(size_t rows)
+{
+    // resize grows the capacity geometrically and the existing rows are moved, not copied
+    Cells.resize(Rows + rows, std::vector<MJCellValue>(Columns));
+    Rows += rows;
+}
 
-	for(size_t i(0); i< RowsInStructure(); ++i)
+void xlw::impl::MJCellMatrix::PushBottom(const xlw::CellMatrix_pimpl_abstract & newRows)
+{
+	if (&newRows == this)
 	{
-		for(size_t j(0); j < Cells.at(i).size(); ++j)
+		MJCellMatrix copy(*this);
+		PushBottom(copy);
+		return;
+	}
+
+	if (newRows.ColumnsInStructure() > Columns)
+	{
+		Columns = newRows.ColumnsInStructure();
+		for(size_t i(0); i < Rows; ++i)
 		{
-			temp(i,j) = Cells.at(i).at(j);
+			Cells[i].resize(Columns);
 		}
 	}
 
-	for(size_t i(0); i< newRows.RowsInStructure(); ++i)
+	size_t oldRows = Rows;
+	AppendRows(newRows.RowsInStructure());
+
+	const MJCellMatrix* mjRows = dynamic_cast<const MJCellMatrix*>(&newRows);
+	try
 	{
-		for(size_t j(0); j < newRows.ColumnsInStructure(); ++j)
+		for(size_t i(0); i< newRows.RowsInStructure(); ++i)
 		{
-			temp(RowsInStructure()+i,j) = newRows(i,j);
+			for(size_t j(0); j < newRows.ColumnsInStructure(); ++j)
+			{
+				if (mjRows)
+					Cells[oldRows+i][j] = mjRows->Cells[i][j];
+				else
+					static_cast<CellValue&>(Cells[oldRows+i][j]) = newRows(i,j);
+			}
 		}
 	}
-
-	*this = temp;
+	catch (...)
+	{
+		// take the new rows off again, shrinking doesn't allocate
+		Cells.resize(oldRows);
+		Rows = oldRows;
+		throw;
+	}
 }
-
-
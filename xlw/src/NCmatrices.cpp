@@ -20,11 +20,28 @@
 // This will not leak. If the new throws it gets cleaned up and the
 // NCMatrix is never created.
 xlw::NCMatrix::NCMatrix(const NCMatrix& original):
-         theData(original.theData.copy())
+         theData(original.shareable ? original.theData : original.theData.copy()),
+         shareable(true)
 {}
 
+// original is left sharing an empty matrix, so moving never allocates
+xlw::NCMatrix::NCMatrix(NCMatrix&& original) noexcept:
+         theData(emptyData()),
+         shareable(true)
+{
+    swap(original);
+}
+
+// unshare copies it before anything is written to it
+const xlw::eshared_ptr<xlw::NCMatrix::NCMatrixData>& xlw::NCMatrix::emptyData()
+{
+    static const eshared_ptr<NCMatrixData> empty(new NCMatrixData(0,0));
+    return empty;
+}
+
 xlw::NCMatrix::NCMatrix(size_t Rows_, size_t Columns_):
-                        theData( new NCMatrixData(Rows_,Columns_))
+                        theData( new NCMatrixData(Rows_,Columns_)),
+                        shareable(true)
 {}
 
 
@@ -51,4 +68,10 @@ xlw::NCMatrix& xlw::NCMatrix::operator=(const NCMatrix& original)
     return *this;
 }
 
+xlw::NCMatrix& xlw::NCMatrix::operator=(NCMatrix&& original) noexcept
+{
+    swap(original);
+    return *this;
+}
+
 
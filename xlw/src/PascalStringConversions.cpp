@@ -20,18 +20,309 @@ FOR A PARTICULAR PURPOSE.  See the license for more details.
 #include <algorithm>
 #include <cctype>
 #include <locale>
+#include <climits>
 
 #ifndef WC_NO_BEST_FIT_CHARS
 #define WC_NO_BEST_FIT_CHARS 0x00000400
 #endif
 
+// the vector paths assume the 16 bit wchar_t of Windows
+#if (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)) && WCHAR_MAX == 0xFFFF
+#define XLW_SSE2_STRINGS
+#include <emmintrin.h>
+#if defined(__AVX2__)
+#define XLW_AVX2_STRINGS
+#include <immintrin.h>
+#endif
+#endif
+
+namespace
+{
+    // most UTF-8 bytes a single wchar_t can need
+    const size_t MaxUtf8PerChar = sizeof(wchar_t) == 2 ? 3 : 4;
+
+    const wchar_t ReplacementCharacter = 0xFFFD;
+
+#ifdef XLW_SSE2_STRINGS
+    bool NarrowAsciiBlock(const wchar_t* from, char* to)
+    {
+        __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from));
+        __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + 8));
+        __m128i outside = _mm_and_si128(_mm_or_si128(first, second), _mm_set1_epi16(static_cast<short>(0xFF80)));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(outside, _mm_setzero_si128())) != 0xFFFF)
+        {
+            return false;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(to), _mm_packus_epi16(first, second));
+        return true;
+    }
+
+    bool WidenAsciiBlock(const char* from, wchar_t* to)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from));
+        // the top bit of each byte is only set outside ASCII
+        if (_mm_movemask_epi8(bytes))
+        {
+            return false;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(to), _mm_unpacklo_epi8(bytes, _mm_setzero_si128()));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(to + 8), _mm_unpackhi_epi8(bytes, _mm_setzero_si128()));
+        return true;
+    }
+#endif
+}
+
+bool xlw::PascalStringConversions::WidenAscii(const char* from, size_t n, wchar_t* to)
+{
+    size_t i(0);
+#ifdef XLW_AVX2_STRINGS
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(from + i));
+        if (_mm256_movemask_epi8(bytes))
+        {
+            return false;
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(to + i), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(bytes)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(to + i + 16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(bytes, 1)));
+    }
+#endif
+#ifdef XLW_SSE2_STRINGS
+    for (; i + 16 <= n; i += 16)
+    {
+        if (!WidenAsciiBlock(from + i, to + i))
+        {
+            return false;
+        }
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        unsigned char c = static_cast<unsigned char>(from[i]);
+        if (c > 0x7F)
+        {
+            return false;
+        }
+        to[i] = c;
+    }
+    return true;
+}
+
+bool xlw::PascalStringConversions::NarrowAscii(const wchar_t* from, size_t n, char* to)
+{
+    size_t i(0);
+#ifdef XLW_AVX2_STRINGS
+    const __m256i high256 = _mm256_set1_epi16(static_cast<short>(0xFF80));
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(from + i));
+        __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(from + i + 16));
+        if (!_mm256_testz_si256(_mm256_or_si256(first, second), high256))
+        {
+            return false;
+        }
+        // packing works within 128 bit lanes so the quarters need putting back in order
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(first, second), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(to + i), packed);
+    }
+#endif
+#ifdef XLW_SSE2_STRINGS
+    for (; i + 16 <= n; i += 16)
+    {
+        if (!NarrowAsciiBlock(from + i, to + i))
+        {
+            return false;
+        }
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        if (static_cast<unsigned int>(from[i]) > 0x7F)
+        {
+            return false;
+        }
+        to[i] = static_cast<char>(from[i]);
+    }
+    return true;
+}
+
+
+size_t xlw::PascalStringConversions::Utf16ToUtf8(const wchar_t* from, size_t n, char* to)
+{
+    char* out = to;
+    size_t i(0);
+    while (i < n)
+    {
+        unsigned long c = static_cast<unsigned long>(from[i]);
+        if (c < 0x80)
+        {
+#ifdef XLW_SSE2_STRINGS
+            // runs of ASCII go 16 characters at a time
+            if (i + 16 <= n && NarrowAsciiBlock(from + i, out))
+            {
+                i += 16;
+                out += 16;
+                continue;
+            }
+#endif
+            *out++ = static_cast<char>(c);
+            ++i;
+            continue;
+        }
+
+        ++i;
+        if (c < 0x800)
+        {
+            *out++ = static_cast<char>(0xC0 | (c >> 6));
+            *out++ = static_cast<char>(0x80 | (c & 0x3F));
+            continue;
+        }
+        if (c >= 0xD800 && c <= 0xDFFF)
+        {
+            unsigned long low = i < n ? static_cast<unsigned long>(from[i]) : 0;
+            if (c < 0xDC00 && low >= 0xDC00 && low <= 0xDFFF)
+            {
+                c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                ++i;
+            }
+            else
+            {
+                c = ReplacementCharacter;
+            }
+        }
+        else if (c > 0x10FFFF)
+        {
+            c = ReplacementCharacter;
+        }
+        if (c < 0x10000)
+        {
+            *out++ = static_cast<char>(0xE0 | (c >> 12));
+            *out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            *out++ = static_cast<char>(0x80 | (c & 0x3F));
+        }
+        else
+        {
+            *out++ = static_cast<char>(0xF0 | (c >> 18));
+            *out++ = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+            *out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            *out++ = static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+    return out - to;
+}
+
+size_t xlw::PascalStringConversions::Utf8ToUtf16(const char* from, size_t n, wchar_t* to)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(from);
+    wchar_t* out = to;
+    size_t i(0);
+    while (i < n)
+    {
+        unsigned long c = bytes[i];
+        if (c < 0x80)
+        {
+#ifdef XLW_SSE2_STRINGS
+            if (i + 16 <= n && WidenAsciiBlock(from + i, out))
+            {
+                i += 16;
+                out += 16;
+                continue;
+            }
+#endif
+            *out++ = static_cast<wchar_t>(c);
+            ++i;
+            continue;
+        }
+
+        size_t length;
+        unsigned long smallest;
+        if ((c & 0xE0) == 0xC0)
+        {
+            length = 2;
+            c &= 0x1F;
+            smallest = 0x80;
+        }
+        else if ((c & 0xF0) == 0xE0)
+        {
+            length = 3;
+            c &= 0x0F;
+            smallest = 0x800;
+        }
+        else if ((c & 0xF8) == 0xF0)
+        {
+            length = 4;
+            c &= 0x07;
+            smallest = 0x10000;
+        }
+        else
+        {
+            // a stray continuation byte or a lead byte UTF-8 doesn't use
+            *out++ = ReplacementCharacter;
+            ++i;
+            continue;
+        }
+
+        size_t taken(1);
+        while (taken < length && i + taken < n && (bytes[i + taken] & 0xC0) == 0x80)
+        {
+            c = (c << 6) | (bytes[i + taken] & 0x3F);
+            ++taken;
+        }
+        i += taken;
+        if (taken < length || c < smallest || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF))
+        {
+            *out++ = ReplacementCharacter;
+        }
+        else if (c >= 0x10000 && sizeof(wchar_t) == 2)
+        {
+            c -= 0x10000;
+            *out++ = static_cast<wchar_t>(0xD800 + (c >> 10));
+            *out++ = static_cast<wchar_t>(0xDC00 + (c & 0x3FF));
+        }
+        else
+        {
+            *out++ = static_cast<wchar_t>(c);
+        }
+    }
+    return out - to;
+}
+
+std::string xlw::PascalStringConversions::WPascalStringToUtf8(const wchar_t* pascalString)
+{
+    size_t n = pascalString[0];
+    std::string result(n * MaxUtf8PerChar, '\0');
+    result.resize(n > 0 ? Utf16ToUtf8(pascalString + 1, n, &result[0]) : 0);
+    return result;
+}
+
+wchar_t* xlw::PascalStringConversions::Utf8ToWPascalString(const std::string& utf8String)
+{
+    size_t n(utf8String.length());
+
+    // UTF-8 never gives more characters than bytes so this is enough room
+    wchar_t* result = TempMemory::GetMemoryUninitialized<wchar_t>(n + 2);
+    n = n > 0 ? Utf8ToUtf16(utf8String.c_str(), n, result + 1) : 0;
+    if (n > 32767)
+    {
+        std::cerr << XLW__HERE__ << "String truncated to 32767 characters" << std::endl;
+        n = 32767;
+        // don't leave half a surrogate pair at the end
+        if (result[n] >= 0xD800 && result[n] < 0xDC00)
+        {
+            --n;
+        }
+    }
+    result[n + 1] = 0;
+    result[0] = static_cast<XCHAR>(n);
+    return result;
+}
 
 char * xlw::PascalStringConversions::PascalStringToString(const char* pascalString)
 {
     // Must use datatype unsigned char (BYTE) to process 0th byte
     // otherwise numbers greater than 128 are incorrect
     size_t n = static_cast<BYTE>(pascalString[0]);
-    char* result = TempMemory::GetMemory<char>(n + 1);
+    char* result = TempMemory::GetMemoryUninitialized<char>(n + 1);
     memcpy(result, pascalString + 1, n);
     result[n] = 0;
     return result;
@@ -43,7 +334,10 @@ std::wstring xlw::PascalStringConversions::PascalStringToWString(const char* pas
     // otherwise numbers greater than 128 are incorrect
     size_t n = static_cast<BYTE>(pascalString[0]);
     std::wstring result(n, L'\0');
-    MultiByteToWideChar(CP_ACP, 0, pascalString + 1, (int)n, &result[0], (int)n);
+    if (n > 0 && !WidenAscii(pascalString + 1, n, &result[0]))
+    {
+        MultiByteToWideChar(CP_ACP, 0, pascalString + 1, (int)n, &result[0], (int)n);
+    }
     return result;
 }
 
@@ -59,7 +353,7 @@ char* xlw::PascalStringConversions::StringToPascalString(const std::string& cStr
     // One byte more for the string length (convention used by Excel)
     // and another so that the string is null terminated so that the
     // debugger sees it correctly
-    LPSTR result = TempMemory::GetMemory<char>(n + 2);
+    LPSTR result = TempMemory::GetMemoryUninitialized<char>(n + 2);
     strncpy(result + 1, cString.c_str(), n);
     result[n + 1] = 0;
     result[0] = static_cast<BYTE>(n);
@@ -79,20 +373,30 @@ char* xlw::PascalStringConversions::WStringToPascalString(const std::wstring& cS
     // and another so that the string is null terminated so that the
     // debugger sees it correctly
     LPSTR result = TempMemory::GetMemory<char>(n + 2);
-    WideCharToMultiByte(CP_ACP, WC_NO_BEST_FIT_CHARS, cString.c_str(), (int)n, result + 1, (int)n, NULL, NULL);
+    if (!NarrowAscii(cString.c_str(), n, result + 1))
+    {
+        WideCharToMultiByte(CP_ACP, WC_NO_BEST_FIT_CHARS, cString.c_str(), (int)n, result + 1, (int)n, NULL, NULL);
+    }
     result[n + 1] = 0;
     result[0] = static_cast<BYTE>(n);
     return result;
 }
 
 char* xlw::PascalStringConversions::WPascalStringToString(const wchar_t* pascalString)
+{
+    size_t length;
+    return WPascalStringToString(pascalString, length);
+}
+
+char* xlw::PascalStringConversions::WPascalStringToString(const wchar_t* pascalString, size_t& length)
 {
     size_t n = pascalString[0];
     char* result = TempMemory::GetMemory<char>(n + 1);
     result[n] = 0;
-    if(n > 0)
+    length = n;
+    if(n > 0 && !NarrowAscii(pascalString + 1, n, result))
     {
-        WideCharToMultiByte(CP_ACP, WC_NO_BEST_FIT_CHARS, pascalString + 1, (int)n, result, (int)n, NULL, NULL);
+        length = WideCharToMultiByte(CP_ACP, WC_NO_BEST_FIT_CHARS, pascalString + 1, (int)n, result, (int)n, NULL, NULL);
     }
     return result;
 }
@@ -118,8 +422,13 @@ wchar_t* xlw::PascalStringConversions::StringToWPascalString(const std::string&
     // One byte more for the string length (convention used by Excel)
     // and another so that the string is null terminated so that the
     // debugger sees it correctly
-    wchar_t* result  = TempMemory::GetMemory<wchar_t>(n+2);
-    MultiByteToWideChar(CP_ACP, 0, cString.c_str(), (int)n, result + 1, (int)n);
+    wchar_t* result  = TempMemory::GetMemoryUninitialized<wchar_t>(n+2);
+    // multibyte characters give fewer wide characters than bytes
+    // so use the count actually written as the length
+    if (n > 0 && !WidenAscii(cString.c_str(), n, result + 1))
+    {
+        n = MultiByteToWideChar(CP_ACP, 0, cString.c_str(), (int)n, result + 1, (int)n);
+    }
     result[n + 1] = 0;
     result[0] = static_cast<XCHAR>(n);
     return result;
@@ -137,7 +446,7 @@ wchar_t* xlw::PascalStringConversions::WStringToWPascalString(const std::wstring
     // One byte more for the string length (convention used by Excel)
     // and another so that the string is null terminated so that the
     // debugger sees it correctly
-    wchar_t* result = TempMemory::GetMemory<wchar_t>(n + 2);
+    wchar_t* result = TempMemory::GetMemoryUninitialized<wchar_t>(n + 2);
     wcsncpy(result + 1, cString.c_str(), n);
     result[n + 1] = 0;
     result[0] = static_cast<wchar_t>(n);
@@ -148,7 +457,7 @@ wchar_t* xlw::PascalStringConversions::WStringToWPascalString(const std::wstring
 char* xlw::PascalStringConversions::PascalStringCopy(const char* pascalString)
 {
     size_t n = static_cast<BYTE>(pascalString[0]);
-    LPSTR result = TempMemory::GetMemory<char>(n + 2);
+    LPSTR result = TempMemory::GetMemoryUninitialized<char>(n + 2);
     memcpy(result, pascalString, n + 1);
     result[n + 1] = 0;
     return result;
@@ -157,7 +466,7 @@ char* xlw::PascalStringConversions::PascalStringCopy(const char* pascalString)
 wchar_t* xlw::PascalStringConversions::WPascalStringCopy(const wchar_t* pascalString)
 {
     size_t n = static_cast<wchar_t>(pascalString[0]);
-    wchar_t* result = TempMemory::GetMemory<wchar_t>(n + 2);
+    wchar_t* result = TempMemory::GetMemoryUninitialized<wchar_t>(n + 2);
     memcpy(result, pascalString, (n + 1) * sizeof(wchar_t));
     result[n + 1] = 0;
     return result;
@@ -0,0 +1,232 @@
+/*
+ This file is part of XLW, a free-software/open-source C++ wrapper of the
+ Excel C API - https://xlw.github.io/
+
+ XLW is free software: you can redistribute it and/or modify it under the
+ terms of the XLW license.  You should have received a copy of the
+ license along with this program; if not, please email xlw-users@lists.sf.net
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*!
+\file StringPool.cpp
+\brief Implements the StringPool class.
+*/
+
+// $Id$
+
+#include <xlw/StringPool.h>
+#include <xlw/CriticalSection.h>
+#include <xlw/XlfException.h>
+#include <atomic>
+#include <algorithm>
+
+namespace
+{
+    struct Entry
+    {
+        Entry() : hash(0), narrow(0) {}
+        std::wstring wide;
+        size_t hash;
+        std::atomic<std::string*> narrow;
+    };
+
+    // entries are allocated in chunks that never move, so a symbol can be
+    // looked up without taking the lock while other threads add strings
+    const size_t ChunkBits = 12;
+    const size_t ChunkSize = size_t(1) << ChunkBits;
+    const size_t MaxChunks = 16384;
+    std::atomic<Entry*> chunks[MaxChunks];
+
+    std::atomic<size_t> entryCount(0);
+    std::atomic<bool> internCellStrings(false);
+
+    // open addressing table of symbols, read without the lock and only
+    // written to under it; a bigger one is swapped in when it fills up and
+    // the old one is kept, as other threads may still be probing it
+    struct Table
+    {
+        explicit Table(size_t size) : mask(size - 1), slots(new std::atomic<xlw::StringPool::Symbol>[size])
+        {
+            for (size_t i = 0; i < size; ++i)
+            {
+                slots[i].store(0, std::memory_order_relaxed);
+            }
+        }
+        size_t mask;
+        std::atomic<xlw::StringPool::Symbol>* slots;
+    };
+    std::atomic<Table*> table(0);
+
+    xlw::CriticalSection& Lock()
+    {
+        static xlw::CriticalSection criticalSection;
+        return criticalSection;
+    }
+
+    Entry& EntryFor(xlw::StringPool::Symbol symbol)
+    {
+        size_t index = symbol - 1;
+        return chunks[index >> ChunkBits].load(std::memory_order_acquire)[index & (ChunkSize - 1)];
+    }
+
+    size_t Hash(const wchar_t* text, size_t length)
+    {
+        // FNV-1a
+        size_t hash = sizeof(size_t) == 8 ? size_t(14695981039346656037ULL) : size_t(2166136261U);
+        const size_t prime = sizeof(size_t) == 8 ? size_t(1099511628211ULL) : size_t(16777619U);
+        for (size_t i = 0; i < length; ++i)
+        {
+            hash ^= static_cast<size_t>(text[i]);
+            hash *= prime;
+        }
+        return hash;
+    }
+
+    // the symbol for text, or 0 with slot set to the empty slot it would go in
+    xlw::StringPool::Symbol Find(const Table& current, const wchar_t* text, size_t length, size_t hash, size_t& slot)
+    {
+        slot = hash & current.mask;
+        for (;;)
+        {
+            xlw::StringPool::Symbol symbol = current.slots[slot].load(std::memory_order_acquire);
+            if (!symbol)
+            {
+                return 0;
+            }
+            Entry& entry(EntryFor(symbol));
+            if (entry.hash == hash && entry.wide.size() == length && std::equal(text, text + length, entry.wide.begin()))
+            {
+                return symbol;
+            }
+            slot = (slot + 1) & current.mask;
+        }
+    }
+
+    // called with the lock held
+    Table* Grow(const Table* current)
+    {
+        size_t size = current ? current->mask + 1 : 0;
+        Table* bigger = new Table(std::max<size_t>(1024, size * 2));
+        for (size_t i = 0; i < size; ++i)
+        {
+            xlw::StringPool::Symbol symbol = current->slots[i].load(std::memory_order_relaxed);
+            if (symbol)
+            {
+                size_t slot = EntryFor(symbol).hash & bigger->mask;
+                while (bigger->slots[slot].load(std::memory_order_relaxed))
+                {
+                    slot = (slot + 1) & bigger->mask;
+                }
+                bigger->slots[slot].store(symbol, std::memory_order_relaxed);
+            }
+        }
+        table.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+}
+
+xlw::StringPool::Symbol xlw::StringPool::Intern(const wchar_t* text, size_t length)
+{
+    Symbol symbol = TryIntern(text, length);
+    if (!symbol)
+    {
+        THROW_XLW("String pool is full");
+    }
+    return symbol;
+}
+
+xlw::StringPool::Symbol xlw::StringPool::TryIntern(const wchar_t* text, size_t length)
+{
+    size_t hash = Hash(text, length);
+    size_t slot;
+
+    // strings already in the pool are found without the lock
+    Table* current = table.load(std::memory_order_acquire);
+    if (current)
+    {
+        Symbol symbol = Find(*current, text, length, hash, slot);
+        if (symbol)
+        {
+            return symbol;
+        }
+    }
+
+    ProtectInScope protect(Lock());
+
+    // look again, another thread may have added it or grown the table
+    current = table.load(std::memory_order_relaxed);
+    size_t count = entryCount.load(std::memory_order_relaxed);
+    if (!current || count * 2 >= current->mask + 1)
+    {
+        current = Grow(current);
+    }
+
+    Symbol found = Find(*current, text, length, hash, slot);
+    if (found)
+    {
+        return found;
+    }
+
+    if (count == MaxChunks * ChunkSize)
+    {
+        return 0;
+    }
+    if ((count & (ChunkSize - 1)) == 0)
+    {
+        chunks[count >> ChunkBits].store(new Entry[ChunkSize], std::memory_order_release);
+    }
+
+    Entry& entry(chunks[count >> ChunkBits].load(std::memory_order_relaxed)[count & (ChunkSize - 1)]);
+    entry.wide.assign(text, length);
+    entry.hash = hash;
+
+    // the entry is filled in before the symbol is published to readers
+    Symbol symbol = static_cast<Symbol>(count + 1);
+    current->slots[slot].store(symbol, std::memory_order_release);
+    entryCount.store(count + 1, std::memory_order_release);
+    return symbol;
+}
+
+const std::wstring& xlw::StringPool::WstringValue(Symbol symbol)
+{
+    return EntryFor(symbol).wide;
+}
+
+const std::string& xlw::StringPool::StringValue(Symbol symbol)
+{
+    Entry& entry(EntryFor(symbol));
+    std::string* narrow = entry.narrow.load(std::memory_order_acquire);
+    if (!narrow)
+    {
+        std::string* made = new std::string(entry.wide.begin(), entry.wide.end());
+        if (entry.narrow.compare_exchange_strong(narrow, made, std::memory_order_acq_rel))
+        {
+            narrow = made;
+        }
+        else
+        {
+            // another thread got there first
+            delete made;
+        }
+    }
+    return *narrow;
+}
+
+size_t xlw::StringPool::Size()
+{
+    return entryCount.load(std::memory_order_acquire);
+}
+
+void xlw::StringPool::InternCellStrings(bool intern)
+{
+    internCellStrings.store(intern, std::memory_order_relaxed);
+}
+
+bool xlw::StringPool::InternsCellStrings()
+{
+    return internCellStrings.load(std::memory_order_relaxed);
+}
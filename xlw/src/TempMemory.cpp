@@ -18,31 +18,12 @@
 */
 
 #include "xlw/TempMemory.h"
-#include "xlw/CriticalSection.h"
-#include "xlw/ThreadLocalStorage.h"
 #include <iostream>
-#include <vector>
 #include <algorithm>
+#include <iterator>
+#include <new>
 #include <xlw/XlfWindows.h>
 
-typedef std::shared_ptr<xlw::TempMemory> TempMemoryPtr;
-
-
-namespace 
-{
-     xlw::ThreadLocalStorage<xlw::TempMemory> tls;
-     xlw::CriticalSection threadInfoVector;
-     std::vector<TempMemoryPtr> tempMemoryInstances;
-}
-namespace
-{
-    bool threadIsDead(const TempMemoryPtr& tempMemory)
-    {
-        return tempMemory->isThreadDead();
-    }
-
-}
-
 namespace xlw {
 
     template<class T>
@@ -55,40 +36,80 @@ namespace xlw {
 
     };
 
+    namespace {
+        // counters have a single writer so a plain load and store
+        // is enough and avoids a locked read-modify-write
+        inline void addTo(std::atomic<size_t>& counter, size_t amount)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+    }
 
+    thread_local TempMemory* TempMemory::threadInstance_ = 0;
+    thread_local TempMemory::ThreadOwner TempMemory::threadOwner_;
+    std::atomic<TempMemory*> TempMemory::instances_(0);
+    std::atomic<bool> TempMemory::largePagesUnavailable_(false);
+    const size_t TempMemory::InitialBufferSize;
+    const size_t TempMemory::LargeAllocationThreshold;
+    const unsigned int TempMemory::LargeRegionIdleCalls;
 
-    char* TempMemory::GetBytes(size_t bytes)
+    inline TempMemory* TempMemory::ThreadInstance()
     {
-        TempMemory* threadStorage = tls.GetValue();
+        TempMemory* threadStorage = threadInstance_;
         if(!threadStorage)
         {
             threadStorage = CreateTempMemory();
         }
-        return threadStorage->InternalGetMemory(bytes);
+        return threadStorage;
+    }
+
+    char* TempMemory::GetBytes(size_t bytes)
+    {
+        char* result = ThreadInstance()->InternalGetMemory(bytes);
+        memset(result, 0, bytes);
+        return result;
+    }
+
+    char* TempMemory::GetBytesUninitialized(size_t bytes)
+    {
+        return ThreadInstance()->InternalGetMemory(bytes);
     }
 
     void TempMemory::EnterExportedFunction() {
-        TempMemory* threadStorage = tls.GetValue();
-        if(!threadStorage)
-        {
-            threadStorage = CreateTempMemory();
-        }
-        threadStorage->InternalEnterExportedFunction();
+        ThreadInstance()->InternalEnterExportedFunction();
     }
 
 
     void TempMemory::LeaveExportedFunction() {
-        TempMemory* threadStorage = tls.GetValue();
+        TempMemory* threadStorage = threadInstance_;
         if(threadStorage)
         {
             threadStorage->InternalLeaveExportedFunction();
         }
     }
 
+    TempMemory::Counters::Counters() :
+        allocations(0),
+        bytesAllocated(0),
+        bufferPushes(0),
+        calls(0),
+        peakCallBytes(0),
+        retainedBytes(0),
+        largeRegionsMapped(0),
+        largeRetainedBytes(0){
+    }
+
     TempMemory::TempMemory() :
         offset_(0),
-        threadId_(GetCurrentThreadId()),
-        depth_(0){
+        filledBytes_(0),
+        retainTarget_(0),
+        callPeakBytes_(0),
+        resets_(0),
+        depth_(0),
+        next_(0),
+        inUse_(true),
+        largeBytesInCall_(0),
+        largeSequence_(0){
     }
 
     TempMemory::~TempMemory() {
@@ -96,14 +117,38 @@ namespace xlw {
     }
 
     void TempMemory::InternalFreeMemory(bool finished) {
-        size_t nbBuffersToKeep = 1;
+        ReleaseLargeRegions(finished);
+        ++resets_;
         if (finished)
-            nbBuffersToKeep = 0;
-        while (freeList_.size() > nbBuffersToKeep) {
-           // delete[] freeList_.back().start; shouldn't need this anymore
-            freeList_.pop_back();
+        {
+            freeList_.clear();
+            offset_ = 0;
+            filledBytes_ = 0;
+            retainTarget_ = 0;
+            counters_.retainedBytes.store(0, std::memory_order_relaxed);
+            return;
+        }
+
+        size_t used = std::max(filledBytes_ + offset_, callPeakBytes_);
+        callPeakBytes_ = 0;
+
+        // keep enough for the largest recent call, letting the target
+        // decay by an eighth each call so a one off spike is eventually
+        // given back
+        retainTarget_ = std::max(used, retainTarget_ - retainTarget_ / 8);
+        size_t wanted = std::max(retainTarget_, InitialBufferSize);
+
+        // consolidate into a single buffer when the last call spilled over
+        // so the next one fits without growing the chain, and shrink when
+        // what we hold is well beyond what is being used
+        if (freeList_.size() > 1 || (!freeList_.empty() && freeList_.front().size > 4 * wanted))
+        {
+            freeList_.clear();
+            counters_.retainedBytes.store(0, std::memory_order_relaxed);
+            PushNewBuffer(wanted);
         }
         offset_ = 0;
+        filledBytes_ = 0;
     }
 
     void TempMemory::InternalEnterExportedFunction() {
@@ -115,38 +160,138 @@ namespace xlw {
     }
 
     void TempMemory::InternalLeaveExportedFunction() {
-        --depth_;
+        if(--depth_ == 0)
+        {
+            size_t used = filledBytes_ + offset_ + largeBytesInCall_;
+            if (used > counters_.peakCallBytes.load(std::memory_order_relaxed))
+                counters_.peakCallBytes.store(used, std::memory_order_relaxed);
+            addTo(counters_.calls, 1);
+        }
+    }
+
+    TempMemory::Mark TempMemory::GetMark() {
+        TempMemory* threadStorage = ThreadInstance();
+        Mark mark;
+        mark.instance = threadStorage;
+        mark.buffers = threadStorage->freeList_.size();
+        mark.offset = threadStorage->offset_;
+        mark.filledBytes = threadStorage->filledBytes_;
+        mark.largeSequence = threadStorage->largeSequence_;
+        mark.resets = threadStorage->resets_;
+        return mark;
+    }
+
+    void TempMemory::RollbackToMark(const Mark& mark) {
+        mark.instance->InternalRollbackToMark(mark);
+    }
+
+    void TempMemory::InternalRollbackToMark(const Mark& mark) {
+        // if the buffers have been reset since, nothing allocated
+        // after the mark is left to release
+        if (mark.resets != resets_)
+            return;
+
+        size_t used = filledBytes_ + offset_;
+        callPeakBytes_ = std::max(callPeakBytes_, used);
+        used += largeBytesInCall_;
+        if (used > counters_.peakCallBytes.load(std::memory_order_relaxed))
+            counters_.peakCallBytes.store(used, std::memory_order_relaxed);
+
+        size_t newBuffers = freeList_.size() - mark.buffers;
+        if (newBuffers == 0)
+        {
+            offset_ = mark.offset;
+            filledBytes_ = mark.filledBytes;
+        }
+        else
+        {
+            // carry on from the newest buffer, which is also the largest, so
+            // a loop that spills over doesn't push a buffer every iteration,
+            // whatever was left in the marked buffer is lost until the next call
+            BufferList::iterator first = freeList_.begin();
+            ++first;
+            BufferList::iterator last = first;
+            std::advance(last, newBuffers - 1);
+            size_t released = 0;
+            for (BufferList::iterator it = first; it != last; ++it)
+            {
+                released += it->size;
+            }
+            freeList_.erase(first, last);
+            counters_.retainedBytes.store(counters_.retainedBytes.load(std::memory_order_relaxed) - released, std::memory_order_relaxed);
+            offset_ = 0;
+            filledBytes_ = mark.filledBytes + mark.offset;
+        }
+
+        if (largeSequence_ != mark.largeSequence)
+        {
+            for (LargeRegionList::iterator it = largeRegions_.begin(); it != largeRegions_.end(); ++it)
+            {
+                if (it->inUse && it->sequence > mark.largeSequence)
+                {
+                    it->inUse = false;
+                    largeBytesInCall_ -= it->used;
+                }
+            }
+        }
     }
 
     TempMemory* TempMemory::CreateTempMemory() {
-        // we want to keep function entry
-        // as fast as possible, so to avoid
-        // needing a critical section around each call
-        // we use a double lock
-        ProtectInScope protecting(threadInfoVector);
-        TempMemory* threadStorage = tls.GetValue();
-        if(!threadStorage)
+        // first try and claim an instance left behind
+        // by a thread that has since exited
+        TempMemory* threadStorage = 0;
+        for(TempMemory* instance = instances_.load(std::memory_order_acquire); instance; instance = instance->next_)
         {
-            // see if any of the existing threads have died
-            // since we where last called
-            tempMemoryInstances.erase(std::remove_if(tempMemoryInstances.begin(), tempMemoryInstances.end(), threadIsDead), tempMemoryInstances.end());
+            bool expected = false;
+            if(instance->inUse_.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            {
+                threadStorage = instance;
+                break;
+            }
+        }
 
-            // create the new memory object
-            TempMemoryPtr smartThreadStorage(new TempMemory);
-            threadStorage = smartThreadStorage.get();
-            tls.SetValue(threadStorage);
-            tempMemoryInstances.push_back(smartThreadStorage);
+        if(!threadStorage)
+        {
+            // nothing to reuse so create a new instance and
+            // push it on the front of the list, instances are
+            // never removed so we don't have to worry about ABA
+            threadStorage = new TempMemory;
+            TempMemory* head = instances_.load(std::memory_order_relaxed);
+            do
+            {
+                threadStorage->next_ = head;
+            }
+            while(!instances_.compare_exchange_weak(head, threadStorage, std::memory_order_release, std::memory_order_relaxed));
         }
+
+        threadOwner_.instance = threadStorage;
+        threadInstance_ = threadStorage;
         return threadStorage;
     }
 
+    TempMemory::ThreadOwner::~ThreadOwner() {
+        // runs on thread exit, release the buffers and
+        // let the next new thread pick up this instance
+        if(instance)
+        {
+            instance->InternalFreeMemory(true);
+            instance->depth_ = 0;
+            instance->inUse_.store(false, std::memory_order_release);
+            instance = 0;
+        }
+        threadInstance_ = 0;
+    }
+
 
     void TempMemory::PushNewBuffer(size_t size) {
         XlfBuffer newBuffer;
         newBuffer.size = size;
         newBuffer.start = shared_char_ptr(new char[size],CustomArrayDeleter<char>());;
         freeList_.push_front(newBuffer);
+        filledBytes_ += offset_;
         offset_=0;
+        addTo(counters_.bufferPushes, 1);
+        addTo(counters_.retainedBytes, size);
     #if !defined(NDEBUG)
         std::cerr << "xlw is allocating a new buffer of " << static_cast<unsigned int>(size) << " bytes" << std::endl;
     #endif
@@ -155,7 +300,11 @@ namespace xlw {
 
     char* TempMemory::InternalGetMemory(size_t bytes) {
         if (freeList_.empty())
-            PushNewBuffer(8192);
+            PushNewBuffer(std::max(retainTarget_, InitialBufferSize));
+        addTo(counters_.allocations, 1);
+        addTo(counters_.bytesAllocated, bytes);
+        if (bytes >= LargeAllocationThreshold)
+            return InternalGetLargeMemory(bytes);
         XlfBuffer& buffer = freeList_.front();
         if (offset_ + bytes > buffer.size) {
             // if we need more space allocate either 50% more than last time
@@ -163,61 +312,185 @@ namespace xlw {
             // space, whichever is greater
             PushNewBuffer(std::max((buffer.size * 3) / 2, (offset_ + bytes) + 4096));
             // buffer no longer valid
-            memset(freeList_.front().start.get(), 0, bytes);
             offset_ = bytes;
             return freeList_.front().start.get();
         }
         else
         {
             size_t temp = offset_;
-            memset(buffer.start.get() + temp, 0, bytes);
             offset_ += bytes;
             return buffer.start.get() + temp;
         }
     }
 
+    TempMemory::Statistics TempMemory::InternalGetStatistics() const {
+        Statistics result;
+        result.allocations = counters_.allocations.load(std::memory_order_relaxed);
+        result.bytesAllocated = counters_.bytesAllocated.load(std::memory_order_relaxed);
+        result.bufferPushes = counters_.bufferPushes.load(std::memory_order_relaxed);
+        result.calls = counters_.calls.load(std::memory_order_relaxed);
+        result.peakCallBytes = counters_.peakCallBytes.load(std::memory_order_relaxed);
+        result.retainedBytes = counters_.retainedBytes.load(std::memory_order_relaxed);
+        result.largeRegionsMapped = counters_.largeRegionsMapped.load(std::memory_order_relaxed);
+        result.largeRetainedBytes = counters_.largeRetainedBytes.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    void TempMemory::InternalResetStatistics() {
+        // retained bytes reflects what we hold right now so is left alone
+        counters_.allocations.store(0, std::memory_order_relaxed);
+        counters_.bytesAllocated.store(0, std::memory_order_relaxed);
+        counters_.bufferPushes.store(0, std::memory_order_relaxed);
+        counters_.calls.store(0, std::memory_order_relaxed);
+        counters_.peakCallBytes.store(0, std::memory_order_relaxed);
+        counters_.largeRegionsMapped.store(0, std::memory_order_relaxed);
+    }
+
+    TempMemory::Statistics TempMemory::GetThreadStatistics() {
+        return ThreadInstance()->InternalGetStatistics();
+    }
+
+    TempMemory::Statistics TempMemory::GetProcessStatistics() {
+        Statistics total;
+        for(TempMemory* instance = instances_.load(std::memory_order_acquire); instance; instance = instance->next_)
+        {
+            Statistics current(instance->InternalGetStatistics());
+            total.allocations += current.allocations;
+            total.bytesAllocated += current.bytesAllocated;
+            total.bufferPushes += current.bufferPushes;
+            total.calls += current.calls;
+            total.peakCallBytes = std::max(total.peakCallBytes, current.peakCallBytes);
+            total.retainedBytes += current.retainedBytes;
+            total.largeRegionsMapped += current.largeRegionsMapped;
+            total.largeRetainedBytes += current.largeRetainedBytes;
+        }
+        return total;
+    }
+
+    void TempMemory::ResetStatistics() {
+        ThreadInstance()->InternalResetStatistics();
+    }
+
+    char* TempMemory::InternalGetLargeMemory(size_t bytes) {
+        largeBytesInCall_ += bytes;
+
+        // take the smallest free region that fits, but don't tie up
+        // one more than twice the size we need
+        LargeRegion* best = 0;
+        for(LargeRegionList::iterator it = largeRegions_.begin(); it != largeRegions_.end(); ++it)
+        {
+            if(!it->inUse && it->size >= bytes && it->size / 2 <= bytes && (!best || it->size < best->size))
+            {
+                best = &*it;
+            }
+        }
+
+        if(!best)
+        {
+            // make room first so we can't lose track of the mapping
+            largeRegions_.reserve(largeRegions_.size() + 1);
+            // leave some headroom so a slightly bigger result
+            // next time can still reuse this region
+            LargeRegion region;
+            region.size = bytes + bytes / 4;
+            region.start = MapRegion(region.size);
+            region.inUse = false;
+            region.idleCalls = 0;
+            region.used = 0;
+            region.sequence = 0;
+            largeRegions_.push_back(region);
+            best = &largeRegions_.back();
+            addTo(counters_.largeRegionsMapped, 1);
+            addTo(counters_.largeRetainedBytes, region.size);
+        #if !defined(NDEBUG)
+            std::cerr << "xlw is mapping a new region of " << static_cast<unsigned int>(region.size) << " bytes" << std::endl;
+        #endif
+        }
+
+        best->inUse = true;
+        best->idleCalls = 0;
+        best->used = bytes;
+        best->sequence = ++largeSequence_;
+        return best->start;
+    }
+
+    void TempMemory::ReleaseLargeRegions(bool finished) {
+        size_t retained = 0;
+        LargeRegionList::iterator keep = largeRegions_.begin();
+        for(LargeRegionList::iterator it = largeRegions_.begin(); it != largeRegions_.end(); ++it)
+        {
+            if(it->inUse)
+            {
+                it->inUse = false;
+            }
+            else
+            {
+                ++it->idleCalls;
+            }
+
+            if(finished || it->idleCalls > LargeRegionIdleCalls)
+            {
+                UnmapRegion(it->start);
+            }
+            else
+            {
+                retained += it->size;
+                *keep++ = *it;
+            }
+        }
+        largeRegions_.erase(keep, largeRegions_.end());
+        largeBytesInCall_ = 0;
+        counters_.largeRetainedBytes.store(retained, std::memory_order_relaxed);
+    }
+
+    char* TempMemory::MapRegion(size_t& size) {
+        if(!largePagesUnavailable_.load(std::memory_order_relaxed))
+        {
+            size_t largePage = GetLargePageMinimum();
+            if(largePage)
+            {
+                size_t rounded = ((size + largePage - 1) / largePage) * largePage;
+                void* start = VirtualAlloc(0, rounded, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+                if(start)
+                {
+                    size = rounded;
+                    return static_cast<char*>(start);
+                }
+            }
+            // large pages need the lock pages in memory privilege
+            // which most users won't have so stop asking for them
+            largePagesUnavailable_.store(true, std::memory_order_relaxed);
+        }
+
+        // round to the allocation granularity as the rest would be wasted anyway
+        const size_t granularity = 65536;
+        size = ((size + granularity - 1) / granularity) * granularity;
+        void* start = VirtualAlloc(0, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        if(!start)
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<char*>(start);
+    }
+
+    void TempMemory::UnmapRegion(char* start) {
+        VirtualFree(start, 0, MEM_RELEASE);
+    }
+
     void TempMemory::InitializeProcess() {
         // turns out we don't need to do anything now
         // left in case we do in the future
     }
 
     void TempMemory::TerminateProcess() {
-        ProtectInScope protecting(threadInfoVector);
-        for(size_t i(0); i < tempMemoryInstances.size(); ++i) {
-            tempMemoryInstances[i]->InternalFreeMemory(true);
+        for(TempMemory* instance = instances_.load(std::memory_order_acquire); instance; instance = instance->next_)
+        {
+            instance->InternalFreeMemory(true);
         }
         // NOTE:
-        // we deliberately don't call tempMemoryInstances.clear()
-        // here as we can't remove the TLS info from other threads
-        // and it's possible for our addin to be reloaded and to reuse 
+        // we deliberately don't delete the instances
+        // here as we can't remove the thread local pointers from other
+        // threads and it's possible for our addin to be reloaded and to reuse
         // calculation threads
     }
-    
-    bool TempMemory::isThreadDead() const
-    {
-        HANDLE threadHandle(OpenThread(THREAD_QUERY_INFORMATION, FALSE, threadId_));
-        if(threadHandle) {
-            DWORD exitCode(0);
-            BOOL result = GetExitCodeThread(threadHandle, &exitCode);
-            CloseHandle(threadHandle);
-            if(result != 0) {
-                if(exitCode == STILL_ACTIVE) {
-                    // still running
-                    return false;
-                }
-                else {
-                    // it's gone
-                    return true;
-                }
-            }
-            else {
-                // fail safe and don't delete in this case
-                return false;
-            }
-        }
-        else {
-            // fail safe and don't delete in this case
-            return false;
-        }
-    }
 }
@@ -22,6 +22,7 @@ FOR A PARTICULAR PURPOSE.  See the license for more details.
 #include <xlw/XlFunctionRegistration.h>
 #include <xlw/CellMatrix.h>
 #include <xlw/TempMemory.h>
+#include <xlw/XlfOper.h>
 #include <xlw/XlfServices.h>
 #include "PathUpdater.h"
 #include<memory>
@@ -98,6 +99,10 @@ extern "C"
             // but keep enough alive so that excel can still use
             // the functions
             xlw::TempMemory::TerminateProcess();
+
+            // stop the threads large results are filled on while it is
+            // still safe to join them
+            xlw::XlfOperImpl::StopFillThreads();
         }
         catch(...)
         {
@@ -19,7 +19,17 @@
 #include <xlw/XlfOper.h>
 #include <xlw/XlfExcel.h>
 #include <xlw/XlfException.h>
+#include <xlw/ArrayPacker.h>
 #include <stdexcept>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <functional>
+#include <exception>
+#include <algorithm>
+#include <iostream>
 #include <assert.h>
 
 namespace
@@ -39,6 +49,246 @@ namespace
         }
         return result;
     }
+
+    std::atomic<size_t> coerceCallbacksSaved(0);
+    std::atomic<size_t> parallelFillThreshold(1 << 16);
+
+    // smallest number of cells worth handing to a thread of its own
+    const size_t MinCellsPerBand = 1 << 14;
+
+    size_t BandsFor(size_t rows, size_t columns)
+    {
+        size_t threshold = parallelFillThreshold.load(std::memory_order_relaxed);
+        size_t cells = rows * columns;
+        if (threshold == 0 || cells < threshold || rows < 2)
+        {
+            return 1;
+        }
+        size_t threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        return std::max<size_t>(1, std::min(std::min(threads, rows), cells / MinCellsPerBand));
+    }
+
+    // a call to RunBands, its bands are taken one at a time by the calling
+    // thread and the pool's workers, only touched under the pool's lock
+    struct BandJob
+    {
+        const std::function<void(size_t, size_t, size_t)>* fill;
+        size_t rows;
+        size_t bands;
+        size_t nextBand;
+        size_t running;
+        std::vector<std::exception_ptr> errors;
+    };
+
+    // workers shared by every calculation thread, so that several threads
+    // filling large results at once don't start more threads than there are cores
+    class FillPool
+    {
+    public:
+        FillPool() : stopping_(false) {}
+
+        // fills every band of job, helped by the workers, started if need be
+        void Run(BandJob& job)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            Start();
+            jobs_.push_back(&job);
+            workAdded_.notify_all();
+            // the caller works on its own job, so it finishes even if every
+            // worker is busy with another thread's
+            for (;;)
+            {
+                size_t band(job.nextBand);
+                if (band == job.bands)
+                {
+                    break;
+                }
+                RunBand(job, band, lock);
+            }
+            bandDone_.wait(lock, [&job]() { return job.running == 0; });
+            Remove(job);
+        }
+
+        // joins the workers, the next Run starts them again
+        void Stop()
+        {
+            std::vector<std::thread> workers;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopping_ = true;
+                workers.swap(workers_);
+                workAdded_.notify_all();
+            }
+            for (size_t i(0); i < workers.size(); ++i)
+            {
+                workers[i].join();
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = false;
+        }
+
+    private:
+        void Start()
+        {
+            if (!workers_.empty())
+            {
+                return;
+            }
+            size_t threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+            try
+            {
+                for (size_t i(1); i < threads; ++i)
+                {
+                    workers_.push_back(std::thread([this]() { Work(); }));
+                }
+            }
+            catch (...)
+            {
+                // couldn't start a thread, callers do more of their own bands
+            }
+        }
+
+        void Work()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            for (;;)
+            {
+                workAdded_.wait(lock, [this]() { return stopping_ || !jobs_.empty(); });
+                if (stopping_)
+                {
+                    return;
+                }
+                BandJob& job(*jobs_.front());
+                RunBand(job, job.nextBand, lock);
+            }
+        }
+
+        // called with the lock held, releases it while the band is filled
+        void RunBand(BandJob& job, size_t band, std::unique_lock<std::mutex>& lock)
+        {
+            ++job.nextBand;
+            ++job.running;
+            if (job.nextBand == job.bands)
+            {
+                Remove(job);
+            }
+            lock.unlock();
+            try
+            {
+                (*job.fill)(band, band * job.rows / job.bands, (band + 1) * job.rows / job.bands);
+            }
+            catch (...)
+            {
+                job.errors[band] = std::current_exception();
+            }
+            lock.lock();
+            if (--job.running == 0 && job.nextBand == job.bands)
+            {
+                bandDone_.notify_all();
+            }
+        }
+
+        void Remove(BandJob& job)
+        {
+            std::vector<BandJob*>::iterator it(std::find(jobs_.begin(), jobs_.end(), &job));
+            if (it != jobs_.end())
+            {
+                jobs_.erase(it);
+            }
+        }
+
+        std::mutex mutex_;
+        std::condition_variable workAdded_;
+        std::condition_variable bandDone_;
+        std::vector<BandJob*> jobs_;
+        std::vector<std::thread> workers_;
+        bool stopping_;
+    };
+
+    // never destroyed, the workers are stopped from xlAutoClose rather than
+    // joined by a static destructor running under the loader lock
+    FillPool& Pool()
+    {
+        static FillPool* pool = new FillPool;
+        return *pool;
+    }
+
+    // calls fill(band, firstRow, endRow) for each band, sharing them
+    // between the calling thread and the pool's workers
+    void RunBands(size_t rows, size_t bands, const std::function<void(size_t, size_t, size_t)>& fill)
+    {
+        if (bands == 1)
+        {
+            fill(0, 0, rows);
+            return;
+        }
+
+        BandJob job;
+        job.fill = &fill;
+        job.rows = rows;
+        job.bands = bands;
+        job.nextBand = 0;
+        job.running = 0;
+        job.errors.resize(bands);
+        Pool().Run(job);
+        for (size_t i(0); i < bands; ++i)
+        {
+            if (job.errors[i])
+            {
+                std::rethrow_exception(job.errors[i]);
+            }
+        }
+    }
+
+    // wide characters taken by the string of a cell in an ArrayPacker block
+    size_t StringSpace(const xlw::CellValue& cell)
+    {
+        if (cell.IsANumber() || cell.IsBoolean() || cell.IsError())
+        {
+            return 0;
+        }
+        if (cell.IsAString())
+        {
+            return xlw::ArrayPacker::StringSpace(cell.StringValue());
+        }
+        if (cell.IsAWstring())
+        {
+            return xlw::ArrayPacker::StringSpace(cell.WstringValue());
+        }
+        return xlw::ArrayPacker::StringSpace(std::wstring());
+    }
+
+    // sets element to the value of cell, putting any string at strings and moving it on
+    void SetElement(XLOPER12& element, const xlw::CellValue& cell, wchar_t*& strings)
+    {
+        if (cell.IsANumber())
+        {
+            element.xltype = xltypeNum;
+            element.val.num = cell.NumericValue();
+        }
+        else if (cell.IsAString())
+        {
+            xlw::ArrayPacker::SetString(element, cell.StringValue(), strings);
+        }
+        else if (cell.IsAWstring())
+        {
+            xlw::ArrayPacker::SetString(element, cell.WstringValue(), strings);
+        }
+        else if (cell.IsBoolean())
+        {
+            element.xltype = xltypeBool;
+            element.val.xbool = cell.BooleanValue();
+        }
+        else if (cell.IsError())
+        {
+            element.xltype = xltypeErr;
+            element.val.err = static_cast<short>(cell.ErrorValue());
+        }
+        else
+        {
+            xlw::ArrayPacker::SetString(element, std::wstring(), strings);
+        }
+    }
 }
 
 namespace xlw
@@ -76,6 +326,89 @@ namespace xlw
 		ThrowOnError(xlretInvXloper, ErrorId, identifier);
 	}
 
+    void XlfOperImpl::AddCoerceCallbacksSaved(size_t saved)
+    {
+        coerceCallbacksSaved.fetch_add(saved, std::memory_order_relaxed);
+    }
+
+    size_t XlfOperImpl::CoerceCallbacksSaved()
+    {
+        return coerceCallbacksSaved.load(std::memory_order_relaxed);
+    }
+
+    void XlfOperImpl::SetParallelFillThreshold(size_t cells)
+    {
+        parallelFillThreshold.store(cells, std::memory_order_relaxed);
+    }
+
+    size_t XlfOperImpl::ParallelFillThreshold()
+    {
+        return parallelFillThreshold.load(std::memory_order_relaxed);
+    }
+
+    void XlfOperImpl::StopFillThreads()
+    {
+        Pool().Stop();
+    }
+
+    void XlfOperImpl::FillInBands(size_t rows, size_t columns, const std::function<void(size_t, size_t)>& fill)
+    {
+        RunBands(rows, BandsFor(rows, columns), [&fill](size_t, size_t firstRow, size_t endRow)
+        {
+            fill(firstRow, endRow);
+        });
+    }
+
+    void XlfOperImpl::SetCellMatrix(LPXLOPER12 oper, const CellMatrix& cells)
+    {
+        ArrayPacker packer(cells.RowsInStructure(), cells.ColumnsInStructure());
+        size_t rows(packer.Rows());
+        size_t columns(packer.Columns());
+
+        size_t bands = BandsFor(rows, columns);
+        if (bands > 1)
+        {
+            cells.PrepareForConcurrentRead();
+        }
+
+        // first find how much room the strings in each band need
+        std::vector<size_t> bandSpace(bands + 1, 0);
+        RunBands(rows, bands, [&](size_t band, size_t firstRow, size_t endRow)
+        {
+            size_t space(0);
+            for (size_t i(firstRow); i < endRow; ++i)
+            {
+                for (size_t j(0); j < columns; ++j)
+                {
+                    space += StringSpace(cells(i, j));
+                }
+            }
+            bandSpace[band + 1] = space;
+        });
+        for (size_t band(0); band < bands; ++band)
+        {
+            bandSpace[band + 1] += bandSpace[band];
+        }
+
+        // TempMemory belongs to this thread so the block is taken here
+        // and the bands write their strings into their own part of it
+        packer.Allocate(bandSpace[bands]);
+        XLOPER12* elements = packer.Elements();
+        wchar_t* strings = packer.Strings();
+        RunBands(rows, bands, [&](size_t band, size_t firstRow, size_t endRow)
+        {
+            wchar_t* next = strings + bandSpace[band];
+            for (size_t i(firstRow); i < endRow; ++i)
+            {
+                for (size_t j(0); j < columns; ++j)
+                {
+                    SetElement(elements[i * columns + j], cells(i, j), next);
+                }
+            }
+        });
+        packer.Finish(oper);
+    }
+
     std::string XlfOperImpl::XlTypeToString(int xlType)
     {
         DWORD type = xlType & 0xFFF;